@@ -1,1105 +1,1377 @@
-/***************************************************************************************
-                System Components and Control Operations
-
-    Control Operations                      Explanation
- -------------------------------------------------------------------------------------
- 1. GPR -> M                [GPR_M]       // Write contents of GPR into addressed memory location
- 2. PC + 1 -> PC            [INCPC]       // Increment PC
- 3. GPR(AD) -> PC           [GPR_PC]      // Transfer address bits in general-purpose register to PC
- 4. PC > MAR               [PC_MAR]      // Transfer from PC to MAR
- 5. GPR(AD) -> MAR          [GPR_MAR]     // Transfer address bits in general-purpose register to MAR
- 6. GPR(OP)-> OPR           [GPR_OPR]     // Transfer operation bits in general-purpose register to OPR
- 7. M -> GPR                [M_GPR]       // Transfer addressed word to GPR
- 8. Acc -> GPR              [Acc_GPR]     // Transfer contents of Acc to GPR
- 9. PC -> GPR(AD)           [PC_GPR]      // Transfer contents of program counter to address part of MAR
- 10. GPR + 1 -> GPR         [INCGPR]      // Increment GPR
- 11. GPR + Acc -> Acc       [ADD]         // Add number in GPR to number in Acc and leave sum in Acc
- 12. 0 -> Acc               [CLRAcc]      // Clear Acc
- 13. ROR F, Acc             [ROR]         // Rotate Acc to right through F
- 14. ROL F. Acc             [ROL]         // Rotate Acc to left through F
- 15. 0 -> F                 [CLRF]        // Reset flip-flop F
- 16. ~F -> F                [COMF]        // Complement flip-flop F
- 17. ~Acc > Acc            [COMAcc]      // Complement Acc
- 18. Acc + 1 > Acc         [INCAcc]      // Increment Acc
-
- ****************************************************************************************/
-
-#include <iostream>
-#include <windows.h>
-#include <memory>
-#include <vector>
-
-
-
-// 18 microoperations + 2
-// 0b [INCA] [COMA] [COMF] [CLRF] [ROL] [ROR] [CLRA] [ADD] [INCGPR] [PC_GPR] [A_GPR] [M_GPR] [GPR_OP] [GPR_MAR] [PC_MAR]  [GPR_PC] [INCPC] [GPR_M]
-
-#define GPR_M       0b00000000000000000000000000000001		// -1  definition of control lines (DWORD 32-bit)
-#define INCPC       0b00000000000000000000000000000010      // -2
-#define GPR_PC      0b00000000000000000000000000000100      // -3
-#define PC_MAR      0b00000000000000000000000000001000      // -4
-#define GPR_MAR     0b00000000000000000000000000010000      // -5
-#define GPR_OP      0b00000000000000000000000000100000      // -6
-#define M_GPR       0b00000000000000000000000001000000      // -7
-#define A_GPR       0b00000000000000000000000010000000      // -8
-#define PC_GPR 	    0b00000000000000000000000100000000      // -9
-#define INCGPR      0b00000000000000000000001000000000      // -10
-#define ADD   		0b00000000000000000000010000000000      // -11
-#define CLRA   		0b00000000000000000000100000000000      // -12
-#define ROR   		0b00000000000000000001000000000000      // -13
-#define ROL   		0b00000000000000000010000000000000      // -14
-#define CLRF   		0b00000000000000000100000000000000      // -15
-#define COMF   		0b00000000000000001000000000000000      // -16
-#define COMA   		0b00000000000000010000000000000000      // -17
-#define INCA   		0b00000000000000100000000000000000      // -18
-#define INCPCF     	0b00010000000000000000000000000000      // -19
-#define INCPCZ     	0b00100000000000000000000000000000      // -20
-#define CLRSC      	0b01000000000000000000000000000000      // -21
-#define HLT        	0b10000000000000000000000000000000      // -22
-
-#define R_nW1   	0b00000000000001000000000000000000
-#define R_nW2   	0b00000000000010000000000000000000
-#define R_nW3   	0b00000000000100000000000000000000
-#define R_nW4   	0b00000000001000000000000000000000
-#define R_nW5   	0b00000000010000000000000000000000
-#define R_nW6   	0b00000000100000000000000000000000
-#define R_nW7   	0b00000001000000000000000000000000
-#define R_nW8   	0b00000010000000000000000000000000
-#define R_nW9   	0b00000100000000000000000000000000
-#define R_nW10   	0b00001000000000000000000000000000
-
-// typedef unsigned char BYTE;        // 8-bits
-// typedef unsigned short int WORD;   // 16-bits
-// typedef unsigned int DWORD;        // 32-bits
-
-class Component							// component interface class of the CPU
-{
-public:
-	virtual void Reset() {}				// virtual defines that this Function will be overwritten in derived classes
-	virtual void RisingEdge() {}        // Control BUS
-	virtual void HighLevel() {}         // for output ( Component -> BUS )
-	virtual void FallingEdge() {}       // increment, complement, swap, clear vb.
-	virtual void LowLevel() {}          // for input   ( BUS -> Component )
+/*******************************************************************************************************************
 
-};
+                            TAUB CPU - command line
 
+    The machine, its engines and tools are in taub.h; this file is the taub executable
+    around them: the option parser, the paced run and the --bench/--batch/--cosim/
+    --fuzz/--sweep drivers. It also counts allocations for --bench, which is why the
+    operator new below lives here and not in the header.
 
-class Register : public Component
-{
-private:
+*******************************************************************************************************************/
 
-    WORD mStore;				// internal storage
-    WORD& mDataBus;
-    DWORD& mControlBus;
-    DWORD mInMask, mOutMask, mIncrMask;
-    WORD mBitMask;
+#include "taub.h"
 
-public:
+static std::atomic<uint64_t> gAllocations(0);     // every operator new call, read by --bench (see BENCHMARK)
 
-    Register(WORD& port, DWORD& ctrl, DWORD inmask, DWORD outmask, DWORD incrmask, WORD bitmask)
-    : mDataBus(port), mControlBus(ctrl), mInMask(inmask), mOutMask(outmask), mIncrMask(incrmask), mBitMask(bitmask) {}  // bitmask - ka bit register ise set eder.
+NOINLINE void* operator new(size_t n, const std::nothrow_t&) noexcept  // every form counts and takes malloc(), every delete frees
+{
+    gAllocations.fetch_add(1, std::memory_order_relaxed);
+    return malloc(n ? n : 1);
+}
 
+NOINLINE void* operator new(size_t n)
+{
+    if (void* p = operator new(n, std::nothrow)) return p;
+    throw std::bad_alloc();
+}
 
-    void HighLevel()        // for output [Component, Memory -> BUS]
-    {
+NOINLINE void* operator new[](size_t n)
+{
+    return operator new(n);
+}
 
-		if (mControlBus & mOutMask)
-		{
-            mDataBus = mStore;
-		}
+NOINLINE void* operator new[](size_t n, const std::nothrow_t&) noexcept
+{
+    return operator new(n, std::nothrow);
+}
 
-    }
+NOINLINE void operator delete(void* p) noexcept
+{
+    free(p);
+}
 
-    void FallingEdge()      // // increment, complement, swap, clear vb.
-    {
-        if ((mControlBus & mIncrMask) || mIncrMask == 0xffff)
-        {
-            Increment();
-        }
-    }
+NOINLINE void operator delete(void* p, size_t) noexcept
+{
+    free(p);
+}
 
-	void LowLevel()      // for input [BUS -> Component, Memory]
-	{
-		if (mControlBus & mInMask)
-		{
-            mStore = mDataBus & mBitMask;
-		}
+NOINLINE void operator delete[](void* p) noexcept
+{
+    free(p);
+}
 
-	}
+NOINLINE void operator delete[](void* p, size_t) noexcept
+{
+    free(p);
+}
 
-    void Reset()
+
+bool RunCoSim(Computer& cpu, size_t runs, uint64_t seed, bool fuzz)   // --cosim: the loaded image, then random ones, on every engine
+{
+    static const char* const names[COSIM_ENGINES] = { "fast", "blocks", "lanes" };
+    std::vector<WORD> loaded(cpu.Ram().Data(), cpu.Ram().Data() + std::min<size_t>(cpu.Ram().Size(), 256));
+    std::vector<WORD> image(256);
+    CoSim cosim(cpu);
+    CoSimReport rep;
+    ProgramFuzzer fuzzer;
+    uint64_t boundaries = 0;            // over the random images
+    size_t diverged = 0;
+
+    cpu.Trace().SetLevel(TRACE_OFF);
+    std::cout << "\n****** COSIM ****** loaded image\n";
+    for (int e = 0; e < COSIM_ENGINES; e++)
     {
-        mStore = 0;
+        diverged += !cosim.Run(loaded.data(), loaded.size(), (CoSimEngine)e, UINT64_MAX, rep);
+        rep.Display(std::cout, names[e]);
     }
 
-    void Set(WORD& data)
+    auto t0 = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < runs; i++)
     {
-        mStore = data & mBitMask;
+        SplitMix rng(seed + i);
+        uint64_t budget = COSIM_MAX_CYCLES;
+        if (fuzz)
+        {
+            budget = 8 * fuzzer.Generate(seed + i, image);  // it halts within this; running past it is a divergence too
+        }
+        else for (WORD& w : image)
+        {
+            w = (WORD)(rng.Next() & 0x0fff);
+        }
+        for (int e = 0; e < COSIM_ENGINES; e++)
+        {
+            if (!cosim.Run(image.data(), image.size(), (CoSimEngine)e, budget, rep))
+            {
+                std::cout << "seed " << (seed + i) << " ";
+                rep.Display(std::cout, names[e]);
+                diverged++;
+            }
+            boundaries += rep.compared;
+        }
     }
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    std::cout << "\n****** COSIM ****** " << runs << (fuzz ? " fuzzed programs" : " random images") << " from seed " << seed << "\n";
+    std::cout << "boundaries    : " << boundaries << "\n";
+    std::cout << "boundaries/sec: " << ((secs > 0.0) ? boundaries / secs : 0.0) << "\n";
+    std::cout << "diverged      : " << diverged << "\n";
+    return diverged == 0;
+}
 
-    WORD Get()
+
+void RunFree(Computer& cpu, uint64_t budget)    // --fast: run unthrottled and report the achieved clock rate
+{
+    auto t0 = std::chrono::steady_clock::now();
+    uint64_t from = cpu.Cycles();
+    RunStatus status = cpu.Run(budget);
+    while (status == RUN_BREAK)         // report and go on; a breakpoint run is not a speed measurement
     {
-        return mStore;
+        cpu.DisplayBreak(std::cout);
+        status = cpu.Run(budget - (cpu.Cycles() - from));
     }
+    auto t1 = std::chrono::steady_clock::now();
+    double secs = std::chrono::duration<double>(t1 - t0).count();
+    uint64_t cycles = cpu.Cycles();
+    double hz = (secs > 0.0) ? cycles / secs : 0.0;
+
+    cpu.DisplayRegs();
+    std::cout << "\n****** FREE RUN ****** " << ((status == RUN_HALTED) ? "halted" : "cycle budget used up") << "\n";
+    std::cout << "cycles       : " << cycles << "\n";
+    std::cout << "seconds      : " << secs << "\n";
+    std::cout << "cycles/sec   : " << hz << "\n";
+    std::cout << "vs 1.8432MHz : " << hz / CLOCK_HZ << "x\n";
+}
 
-    void Increment()
+void RunFast(Computer& cpu, uint64_t budget, bool blocks)   // --engine fast|blocks: same image on the instruction interpreter
+{
+    FastCpu fast;
+    fast.SetBlockCache(blocks);
+    fast.Load(cpu.Ram().Data(), cpu.Ram().Size());
+
+    auto t0 = std::chrono::steady_clock::now();
+    RunStatus status = fast.Run(budget);
+    auto t1 = std::chrono::steady_clock::now();
+    double secs = std::chrono::duration<double>(t1 - t0).count();
+    uint64_t cycles = fast.Cycles() - 1;   // Reset() already counted fetch step 0
+    double hz = (secs > 0.0) ? cycles / secs : 0.0;
+
+    fast.DisplayRegs();
+    std::cout << "\n****** FAST ENGINE ****** " << ((status == RUN_HALTED) ? "halted" : "cycle budget used up") << "\n";
+    std::cout << "cycles       : " << fast.Cycles() << "\n";
+    std::cout << "instructions : " << fast.Instructions() << "\n";
+    if (blocks)
     {
-        mStore = (mStore + 1) & mBitMask;
+        std::cout << "blocks built : " << fast.BlocksBuilt() << "\n";
+        std::cout << "blocks drop  : " << fast.BlocksDropped() << "\n";
     }
+    std::cout << "seconds      : " << secs << "\n";
+    std::cout << "cycles/sec   : " << hz << "\n";
+    std::cout << "vs 1.8432MHz : " << hz / CLOCK_HZ << "x\n";
+}
 
- };
-
- class GprBus: public Component
+double BenchSchedule(Computer& cpu, Schedule s, const std::vector<WORD>& image, int repeats)   // cycles/sec
 {
-private:
-
-    WORD mStore;				// internal storage
-    WORD& mDataBus;
-    DWORD& mControlBus;
-    DWORD mInMask, mOutMask;
-    std::shared_ptr<Register> mPC, mOPR, mGPR;
+    uint64_t cycles = 0;
 
-public:
-
-    GprBus(WORD& port, DWORD& ctrl, DWORD inmask, DWORD outmask, std::shared_ptr<Register> pc, std::shared_ptr<Register> opr, std::shared_ptr<Register> gpr)
-	: mDataBus(port), mControlBus(ctrl), mInMask(inmask), mOutMask(outmask), mPC(pc), mOPR(opr), mGPR(gpr) {}
-
-
-    void HighLevel()        // for output [Component -> BUS]
+    cpu.SetSchedule(s);
+    cpu.LoadProgram(image.data(), (WORD)image.size());
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < repeats; i++)
     {
-
+        cpu.Reload();
+        cpu.Run(UINT64_MAX);
+        cycles += cpu.Cycles();
     }
+    auto t1 = std::chrono::steady_clock::now();
+    double secs = std::chrono::duration<double>(t1 - t0).count();
+    return (secs > 0.0) ? cycles / secs : 0.0;
+}
 
-    void FallingEdge()
-    {
-        WORD a, b;
+void BenchPipeline(Computer& cpu, int repeats)  // --bench-pipeline: dynamic and event Component graph vs StaticPipeline
+{
+    std::vector<WORD> image(cpu.Ram().Data(), cpu.Ram().Data() + cpu.Ram().Size());
+
+    BenchSchedule(cpu, SCHED_DYNAMIC, image, repeats / 10 + 1);    // warm-up
+    double dyn = BenchSchedule(cpu, SCHED_DYNAMIC, image, repeats);
+    double evt = BenchSchedule(cpu, SCHED_EVENT, image, repeats);
+    double sta = BenchSchedule(cpu, SCHED_STATIC, image, repeats);
+
+    std::cout << "\n****** PIPELINE ****** " << repeats << " runs to HLT\n";
+    std::cout << "dynamic cycles/sec : " << dyn << "\n";
+    std::cout << "event   cycles/sec : " << evt << "\n";
+    std::cout << "static  cycles/sec : " << sta << "\n";
+    std::cout << "speed-up           : " << ((dyn > 0.0) ? evt / dyn : 0.0) << "x event, "
+              << ((dyn > 0.0) ? sta / dyn : 0.0) << "x static\n";
+}
 
-        if (mControlBus & mInMask)
-		{
-            if ((mControlBus & mInMask) == PC_GPR)
-            {
-                a = mPC->Get() & 0x00ff;
-                b = mGPR->Get() & 0x00ff;
-                mPC->Set(b);
-                mGPR->Set(a);
-            }
+/*******************************************************************************************************************
 
-            if ((mControlBus & mInMask) == GPR_OP)
-            {
-                a = mGPR->Get() >> 8;
-                mOPR->Set(a);
-            }
+                            BENCHMARK
+    ------------------------------------------------------------------
+     --bench [samples]      every ReferencePrograms[] entry on every engine
+     --bench-out file       also write the results as .csv or .json (by extension)
+     --bench-startup [n]    construct -> first retired instruction, per variant
+    ------------------------------------------------------------------
+     dynamic    Computer, Component graph (SCHED_DYNAMIC)
+     event      Computer, Component graph, active components only (SCHED_EVENT)
+     static     Computer, StaticPipeline (SCHED_STATIC)
+     fast       FastCpu instruction interpreter
+     blocks     FastCpu with the block cache
+    ------------------------------------------------------------------
 
-		}
-    }
+    One run = reload the image, reset, run to HLT. For blocks the reload keeps the blocks
+    over unchanged code (FastCpu::Load()), so after the warm-up the runs measure replay,
+    not translation. A warm-up of at least BENCH_WARMUP_MS sizes the sample so that one
+    sample takes about BENCH_SAMPLE_MS; the per-sample ns/instruction over all samples
+    gives min, median, mean and standard deviation.
+    Allocations come from the counting operator new at the top of the file, per run;
+    the hot loops are expected to stay at 0. The final memory of every engine is compared
+    with the first engine's so a wrong result shows up as a mismatch, not a speed-up.
 
-    void LowLevel()      // for input [BUS -> Component]
-	{
+    --bench-startup times one run = one machine taken from nothing to the end of its
+    first instruction. The paths are: the constructor alone, a new Computer with the
+    image loaded, a reused Computer that only gets Load() (what a BatchRunner worker
+    does per job), and FastCpu. The ns/instruction column becomes ns/run.
 
+*******************************************************************************************************************/
 
-	}
+#define BENCH_WARMUP_MS     20
+#define BENCH_SAMPLE_MS     20
+#define BENCH_MAX_CYCLES    10000000    // per run, in case a program does not halt
 
+struct BenchResult
+{
+    const char* program;
+    const char* engine;
+    uint64_t cycles;                    // per run
+    uint64_t instructions;              // per run, HLT included
+    uint64_t runs;                      // measured runs over all samples
+    double nsMin, nsMedian, nsMean, nsStddev;   // ns/instruction over the samples
+    double cyclesPerSec;                // at the median
+    double allocsPerRun;
+    bool match;                         // final memory equals the first engine's
 };
 
-class Adder : public Component
+template<typename RunOnce>              // RunOnce() performs one run and sets cycles/instructions
+void BenchMeasure(RunOnce runOnce, int samples, BenchResult& res)
 {
-private:
+    using Clock = std::chrono::steady_clock;
+    uint64_t warm = 0;
+    double elapsed = 0.0;
 
-    WORD mNextFlag, mFlagZ, mFlagF;
-    WORD mTemp;
-    WORD mStore;
-    WORD& mDataBus;
-    DWORD& mControlBus;
-    DWORD mInMask, mOutMask;
-    std::shared_ptr<Register> mRegAcc, mRegGpr, mRegF;
-
-public:
-	Adder(WORD& port, DWORD& ctrl, DWORD inmask, DWORD outmask, std::shared_ptr<Register> acc, std::shared_ptr<Register> gpr, std::shared_ptr<Register> flg)
-	: mDataBus(port), mControlBus(ctrl), mInMask(inmask), mOutMask(outmask), mRegAcc(acc), mRegGpr(gpr), mRegF(flg) {}
-
-	void HighLevel()       // for output
+    auto t0 = Clock::now();
+    while (elapsed * 1000.0 < BENCH_WARMUP_MS || warm < 3)
     {
-
-		mStore = (mRegAcc->Get() + mRegGpr->Get()) & 0x0fff ;
-
-		if (mControlBus & mOutMask)
-		{
-			// mDataBus = mRegAcc->Get();
-		}
+        runOnce();
+        warm++;
+        elapsed = std::chrono::duration<double>(Clock::now() - t0).count();
     }
+    uint64_t perSample = (uint64_t)(warm * (BENCH_SAMPLE_MS / 1000.0) / elapsed);
+    if (perSample == 0) perSample = 1;
 
-    void FallingEdge()
+    std::vector<double> ns(samples);
+    uint64_t allocs = gAllocations.load(std::memory_order_relaxed);
+    for (int s = 0; s < samples; s++)
     {
-        WORD a;
+        auto s0 = Clock::now();
+        for (uint64_t r = 0; r < perSample; r++)
+        {
+            runOnce();
+        }
+        double secs = std::chrono::duration<double>(Clock::now() - s0).count();
+        ns[s] = secs * 1e9 / (double)(perSample * (res.instructions ? res.instructions : 1));
+    }
+    allocs = gAllocations.load(std::memory_order_relaxed) - allocs;
+
+    res.runs = perSample * samples;
+    res.allocsPerRun = (double)allocs / res.runs;
+    res.nsMean = 0.0;
+    for (double v : ns) res.nsMean += v;
+    res.nsMean /= samples;
+    res.nsStddev = 0.0;
+    for (double v : ns) res.nsStddev += (v - res.nsMean) * (v - res.nsMean);
+    res.nsStddev = (samples > 1) ? sqrt(res.nsStddev / (samples - 1)) : 0.0;
+    std::sort(ns.begin(), ns.end());
+    res.nsMin = ns.front();
+    res.nsMedian = (samples & 1) ? ns[samples / 2] : (ns[samples / 2 - 1] + ns[samples / 2]) / 2.0;
+    res.cyclesPerSec = (res.nsMedian > 0.0) ? (double)res.cycles / (res.nsMedian * res.instructions) * 1e9 : 0.0;
+}
 
-        mNextFlag = mRegF->Get();
-        (mNextFlag & 0x0001) ?  mFlagF = 1 : mFlagF = 0;        // Save Current Flag;
+void WriteBenchResults(const std::vector<BenchResult>& results, const char* path)
+{
+    std::ofstream out(path);
+    bool json = (strlen(path) > 5 && strcmp(path + strlen(path) - 5, ".json") == 0);
 
-		if (mRegGpr->Get())           // 0b0000'00ZF
+    if (json)
+    {
+        out << "[\n";
+        for (size_t i = 0; i < results.size(); i++)
         {
-            mNextFlag = mNextFlag & 0x0001; // set Z = 0 bit 1 in Flag Reg. 0b0000'000F
-            mRegF->Set(mNextFlag) ;
+            const BenchResult& r = results[i];
+            out << "  {\"program\": \"" << r.program << "\", \"engine\": \"" << r.engine
+                << "\", \"cycles\": " << r.cycles << ", \"instructions\": " << r.instructions
+                << ", \"runs\": " << r.runs << ", \"ns_per_instruction\": {\"min\": " << r.nsMin
+                << ", \"median\": " << r.nsMedian << ", \"mean\": " << r.nsMean << ", \"stddev\": " << r.nsStddev
+                << "}, \"cycles_per_sec\": " << r.cyclesPerSec << ", \"allocs_per_run\": " << r.allocsPerRun
+                << ", \"match\": " << (r.match ? "true" : "false") << "}" << ((i + 1 < results.size()) ? "," : "") << "\n";
         }
-		else
+        out << "]\n";
+    }
+    else
+    {
+        out << "program,engine,cycles,instructions,runs,ns_min,ns_median,ns_mean,ns_stddev,cycles_per_sec,allocs_per_run,match\n";
+        for (const BenchResult& r : results)
         {
-            mNextFlag = mNextFlag | 0x0002;   // set Z = 0 bit 1 in Flag Reg. 0b0000'001F
-            mRegF->Set(mNextFlag) ;         // if GPR = 0 => Z = 1
+            out << r.program << "," << r.engine << "," << r.cycles << "," << r.instructions << "," << r.runs << ","
+                << r.nsMin << "," << r.nsMedian << "," << r.nsMean << "," << r.nsStddev << ","
+                << r.cyclesPerSec << "," << r.allocsPerRun << "," << (r.match ? 1 : 0) << "\n";
         }
+    }
+}
 
-        if (mControlBus & mInMask)
-		{
-            if ((mControlBus & mInMask) == A_GPR)
-            {
-                a = (mRegAcc->Get() & 0x0fff);
-                mRegGpr->Set(a);
-            }
-
-            if ((mControlBus & mInMask) == ADD)
-            {
-                mRegAcc->Set(mStore);
-            }
-
-            if ((mControlBus & mInMask) == COMA)
-            {
-                a = (~(mRegAcc->Get()) & 0x0fff);   // a = ((mRegAcc->Get() ^ 0xffff) & 0x0fff);
-                mRegAcc->Set(a);
-            }
+bool Bench(Computer& cpu, int samples, const char* outPath)    // --bench: false if any engine disagreed
+{
+    static const char* engineNames[] = { "dynamic", "event", "static", "fast", "blocks" };
+    static const Schedule schedules[] = { SCHED_DYNAMIC, SCHED_EVENT, SCHED_STATIC };
+    std::vector<BenchResult> results;
+    FastCpu fast;
+    bool ok = true;
 
-            if ((mControlBus & mInMask) == COMF)
-            {
-                a = (((mRegF->Get()) ^ 0x0001) & 0x0003);
-                mRegF->Set(a);
-            }
+    cpu.Trace().SetLevel(TRACE_OFF);
+    std::cout << "\n****** BENCH ****** " << samples << " samples per program and engine\n";
+    std::cout << "program   engine    cycles  instr   ns/instr (min/median/mean +- sd)        cycles/sec   allocs/run\n";
 
-            if ((mControlBus & mInMask) == CLRA)
-            {
-                mRegAcc->Reset();
-            }
+    for (const ReferenceProgram& p : ReferencePrograms)
+    {
+        std::vector<WORD> reference;
 
-            if ((mControlBus & mInMask) == CLRF)
-            {
-                a = ((mRegF->Get()) & 0x0002);
-                mRegF->Set(a);
-            }
+        for (int e = 0; e < 5; e++)
+        {
+            BenchResult res = {};
+            std::vector<WORD> mem;
 
-            if ((mControlBus & mInMask) == ROL)
+            res.program = p.name;
+            res.engine = engineNames[e];
+            if (e < 3)
             {
-                RolAcc();
+                cpu.SetSchedule(schedules[e]);
+                cpu.LoadProgram(p.image, p.size);
+                BenchMeasure([&]() {
+                    cpu.Reload();
+                    cpu.Run(BENCH_MAX_CYCLES);
+                    res.cycles = cpu.Cycles();
+                    res.instructions = cpu.Counters().instructions;
+                }, samples, res);
+                mem.assign(cpu.Ram().Data(), cpu.Ram().Data() + cpu.Ram().Size());
             }
-
-            if ((mControlBus & mInMask) == ROR)
+            else
             {
-                RorAcc();
+                fast.SetBlockCache(e == 4);
+                BenchMeasure([&]() {
+                    fast.Load(p.image, p.size);
+                    fast.Reset();
+                    fast.Run(BENCH_MAX_CYCLES);
+                    res.cycles = fast.Cycles();
+                    res.instructions = fast.Instructions();
+                }, samples, res);
+                mem.assign(fast.State().mem, fast.State().mem + cpu.Ram().Size());
             }
 
-		}
-
+            if (e == 0) reference = mem;
+            res.match = (mem == reference);
+            ok &= res.match;
+            results.push_back(res);
+
+            std::cout << std::left << std::setw(10) << res.program << std::setw(10) << res.engine
+                      << std::setw(8) << res.cycles << std::setw(8) << res.instructions
+                      << std::fixed << std::setprecision(2) << std::setw(8) << res.nsMin << std::setw(8) << res.nsMedian
+                      << std::setw(8) << res.nsMean << "+- " << std::setw(17) << res.nsStddev
+                      << std::scientific << std::setw(13) << res.cyclesPerSec << std::defaultfloat << res.allocsPerRun
+                      << (res.match ? "" : "   MISMATCH") << "\n" << std::right;
+        }
     }
 
-    void RolAcc()
+    if (outPath)
     {
-        mStore = mRegAcc->Get();
-        if (mStore & 0x0800)
-        {
-            mNextFlag |= 0x0001;
-            mRegF->Set(mNextFlag);
-        }
-        else
-        {
-            mNextFlag &= 0x0002;
-            mRegF->Set(mNextFlag);  // if msb =1 F flag is 1 else 0.
-        }
-        mStore = ((mStore << 1) & 0x0fff) | mFlagF;
-        mRegAcc->Set(mStore);
+        WriteBenchResults(results, outPath);
     }
+    return ok;
+}
 
-    void RorAcc()
+uint64_t FirstInstruction(Computer& cpu)   // steps a freshly reset machine through its first instruction; returns the clocks
+{
+    cpu.Step();                         // fetch 0: SC 0 -> 1
+    do
     {
-        WORD acc;
-        acc = mRegAcc->Get();
-        if (acc & 0x0001)
-        {
-            mNextFlag |= 0x0001;
-            mRegF->Set(mNextFlag);
-        }
-        else
-        {
-            mNextFlag &= 0x0002;
-            mRegF->Set(mNextFlag);  // if lsb =1 F flag is 1 else 0.
-        }
-        acc = ((acc >> 1) & 0x0fff);
-        mFlagF ? (acc |= 0x0800) : (acc |= 0x0000);
-        mRegAcc->Set(acc);
+        cpu.Step();                     // up to the CLRSC (or HLT) clock, which starts the next fetch
     }
+    while (cpu.State().reg[REG_SC] != 1 && !cpu.Halted());
+    return cpu.Cycles();
+}
 
-};
-
-class Memory : public Component
+bool BenchStartup(Computer& cpu, int samples)   // --bench-startup: construct -> first instruction retired, per variant
 {
-private:
-    WORD  mStore[128];				// internal storage 16 bit (12-bit used)
-    WORD& mDataBus;
-    DWORD& mControlBus;
-    DWORD mInMask, mOutMask;
-    std::shared_ptr<Register> mMAR;
-    WORD n_size;
-
-public:
+    std::vector<WORD> image(cpu.Ram().Size());
+    cpu.ReadMem(0, image.size(), image.data());
+    uint64_t sink = 0;
+    bool ok = true;
+
+    std::cout << "\n****** STARTUP ****** " << samples << " samples, the loaded image, " << image.size() << " words\n";
+    std::cout << "variant   path         clocks  ns/run (min/median/mean +- sd)         allocs/run\n";
+    for (int v = 0; v < VARIANT_COUNT; v++)
+    {
+        static const char* paths[] = { "construct", "first-instr", "reload", "fast" };
+        Computer warm(cpu.Layout(), (MachineVariant)v);
 
-    Memory(WORD& port, DWORD& ctrl, DWORD inmask, DWORD outmask, std::shared_ptr<Register> mar)
-	: mDataBus(port), mControlBus(ctrl), mInMask(inmask), mOutMask(outmask), mMAR(mar)
-	{
-/*
-            SUMMARY OF INSTRUCTIONS                                    [Opcode]
-    ----------------------------------------------------------------------------
-     1. CRA clear accumulator   ........................................[0001]
-     2. CTA complement accumulator  ....................................[0010]
-     3. ITA increment accumulator   ....................................[0011]
-     4. CRF clear flip-flop F   ........................................[0100]
-     5. CTF complement flip-flop F  ....................................[0101]
-     6. SFZ skip next instruction if F = 0  ............................[0110]
-     7. ROR rotate right    ............................................[0111]
-     8. ROL rotate left     ............................................[1000]
-     9. ADD add to accumulator  ........................................[1001]
-     10. ADDI add indirect to accumulator   ............................[1010]
-     11. STA store in memory from accumulator   ........................[1011]
-     12. JMP jump       .........,,,,,,,,...............................[1100]
-     13. JMPI jump indirect     ........................................[1101]
-     14. CSR call subroutine    ........................................[1110]
-     15. ISZ increment and skip if Z = 0    ............................[1111]
-     16. HLT Halt       ................................................[0000]
-    -----------------------------------------------------------------------------
-
-*/
-
-        WORD prg[] = {
-            0b0000'0001'0000'0000, // 00 CRA x x        CRA
-            0b0000'1001'0001'0011, // 01 ADD 1 3        ADD NUMA
-            0b0000'1011'0001'0110, // 02 STA 1 6        STA NUM
-            0b0000'1110'0001'1000, // 03 CSR 1 8        CSR DBL
-            0b0000'1001'0001'0111, // 04 ADD 1 7        ADD SUM
-            0b0000'1011'0001'0111, // 05 STA 1 7        STA SUM
-            0b0000'0001'0000'0000, // 06 CRA x x        CRA
-            0b0000'1001'0001'0100, // 07 ADD 1 4        ADD NUMB
-            0b0000'1011'0001'0110, // 08 STA 1 6        STA NUM
-            0b0000'1110'0001'1000, // 09 CSR 1 8        CSR DBL
-            0b0000'1001'0001'0111, // 10 ADD 1 7        ADD SUM
-            0b0000'1011'0001'0111, // 11 STA 1 7        STA SUM
-            0b0000'0001'0000'0000, // 12 CRA x x        CRA
-            0b0000'1001'0001'0101, // 13 ADD 1 5        ADD NUMC
-            0b0000'1011'0001'0110, // 14 STA 1 6        STA NUM
-            0b0000'1110'0001'1000, // 15 CSR 1 8        CSR DBL
-            0b0000'1001'0001'0111, // 16 ADD 1 7        ADD SUM
-            0b0000'1011'0001'0111, // 17 STA 1 7        STA SUM
-            0b0000'0000'0000'0000, // 18 HLT x x        HLT
-            0b0000'0000'0000'0011, // 19 0 0 3  [NUMA]  [3]
-            0b0000'0000'0001'0001, // 20 0 1 1  [NUMB]  [17]
-            0b0000'0000'0010'0000, // 21 0 2 0  [NUMC]  [32]
-            0b0000'0000'0000'0000, // 22 0 0 0  [NUM]
-            0b0000'0000'0000'0000, // 23 0 0 0  [SUM]   [104] <- Result
-            0b0000'0000'0000'0000, // 24 x x x     [SUB DBL]
-            0b0000'0001'0000'0000, // 25 CRA  x x       CRA
-            0b0000'1001'0001'0110, // 26 ADD  1 6       ADD NUM
-            0b0000'1000'0000'0000, // 27 ROL  x x       ROL
-            0b0000'1101'0001'1000, // 28 JMPI 1 8       JMPI [SUB DBL]
-            0b0000'0000'0000'0000, // 29
-            0b0000'0000'0000'0000 };
-
-/*  Prog -7
-     WORD prg[] = {
-            0b0000'0001'0000'0000, // 00 CRA x x        CRA
-            0b0000'0101'0000'0000, // 01 CTF x x        CTF
-            0b0000'1000'0000'0000, // 02 ROL x x   lOOP ROL
-            0b0000'1111'0000'0111, // 03 ISZ 0 7        ISZ CTR
-            0b0000'0110'0000'0000, // 04 SFZ x x        SFZ
-            0b0000'0000'0000'0000, // 05 HLT x x        HLT
-            0b0000'1100'0000'0010, // 06 JMP 0 2        JMP LOOP
-            0b0000'0000'0000'0000, // 07 0 0 0  [CTR]
-            0b0000'0000'0000'0000, // 08
-            0b0000'0000'0000'0000 };
-
-*/
-
-/*  Prog - 6
-        WORD prg[] = {
-            0b0000'0001'0000'0000, // 00 CRA x x        CRA
-            0b0000'0101'0000'0000, // 01 CTF x x        CTF
-            0b0000'0111'0000'0000, // 02 ROR x x   lOOP ROR
-            0b0000'1111'0000'0111, // 03 ISZ 0 7        ISZ CTR
-            0b0000'0110'0000'0000, // 04 SFZ x x        SFZ
-            0b0000'0000'0000'0000, // 05 HLT x x        HLT
-            0b0000'1100'0000'0010, // 06 JMP 0 2        JMP LOOP
-            0b0000'0000'0000'0000, // 07 0 0 0  [CTR]
-            0b0000'0000'0000'0000, // 08
-            0b0000'0000'0000'0000 };
-*/
-
-
-/*  Prog - 5
-         WORD prg[] = {
-            0b0000'0001'0000'0000, // 00 CRA x x    CRA
-            0b0000'1001'0000'1101, // 01 ADD 0 7    ADD SUB1
-            0b0000'0010'0000'0000, // 02 CTA x x    CTA
-            0b0000'0011'0000'0000, // 03 ITA x x    ITA
-            0b0000'1011'0000'1101, // 04 STA 0 9    STA SUB1
-            0b0000'0001'0000'0000, // 05 CRA x x    CRA
-            0b0000'1001'0000'1110, // 06 ADD 0 7    ADD SUB2
-            0b0000'0010'0000'0000, // 07 CTA x x    CTA
-            0b0000'0011'0000'0000, // 08 ITA x x    ITA
-            0b0000'1001'0000'1101, // 09 ADD 0 7    ADD SUB1
-            0b0000'1001'0000'1111, // 10 ADD 0 8    ADD MIN
-            0b0000'1011'0001'0000, // 11 STA 0 9    STA DIF
-            0b0000'0000'0000'0000, // 12 HLT x x    HLT
-            0b0000'0000'0000'0101, // 13 0 0 0  [SUB1]
-            0b0000'0000'1001'1100, // 14 0 9 C  [SUB2]
-            0b0000'0000'1011'0111, // 15 0 B 7  [MIN]
-            0b0000'0000'0000'0000, // 16 x x x  [DIF]
-            0b0000'0000'0000'0000, // 17
-            0b0000'0000'0000'0000 };
-
-*/
-
-/*  Prog - 4
-         WORD prg[] = {
-            0b0000'0001'0000'0000, // 00 CRA  x x           CRA
-            0b0000'1011'0001'1000, // 01 STA  1 8           STA SP
-            0b0000'0001'0000'0000, // 02 CRA  x x     LOOP  CRA
-            0b0000'1001'0001'0111, // 03 ADD  1 7           ADD MR
-            0b0000'0111'0000'0000, // 04 ROR  x x           ROR
-            0b0000'1011'0001'0111, // 05 STA  1 7           STA MR
-            0b0000'0110'0000'0000, // 06 SFZ  x x           SFZ
-            0b0000'1100'0000'1001, // 07 JMP  0 9           JMP 1
-            0b0000'1100'0000'1110, // 08 JMP  0 E           JMP 0
-            0b0000'0001'0000'0000, // 09 CRA  x x         1 CRA
-            0b0000'1001'0001'0110, // 10 ADD  1 6           ADD MD
-            0b0000'1001'0001'1000, // 11 ADD  1 8           ADD SP
-            0b0000'1011'0001'1000, // 12 STA  1 8           STA SP
-            0b0000'0100'0000'0000, // 13 CRF  x x           CRF
-            0b0000'0001'0000'0000, // 14 CRA  x x         0 CRA
-            0b0000'1001'0001'0110, // 15 ADD  1 6           ADD MD
-            0b0000'1000'0000'0000, // 16 ROL  x x           ROL
-            0b0000'1011'0001'0110, // 17 STA  1 6           STA MD
-            0b0000'1111'0001'0101, // 18 ISZ  1 5           1SZ CTR
-            0b0000'1100'0000'0010, // 19 JMP  0 2           JMP LOOP
-            0b0000'0000'0000'0000, // 20 HLT  x x           HLT
-            0b1111'1111'1111'0100, // 21 F F 4  [CTR] (-12)
-            0b0000'0000'0110'0100, // 22 0 6 4  [MD]    // Multiplicand (100)
-            0b0000'0000'0000'0010, // 23 0 0 2  [MR]    // Multiplier   (3)
-            0b0000'0000'0000'0000, // 24 0 0 0  [SP]    // Result       (300) (12C)H
-            0b0000'0000'0000'0000, // 25 0 0 0
-            0b0000'0000'0000'0000, // 26 0 0 0
-            0b0000'0000'0000'0000 };
-
-*/
-
-
-/*  Prog - 3
-        WORD prg[] = {
-            0b0000'0001'0000'0000, // 00 CRA  x x           CRA
-            0b0000'1010'0000'1000, // 01 ADDI 0 8     LOOP  ADDI ANA
-            0b0000'1111'0000'1000, // 02 ISZ  0 8           ISZ ANA
-            0b0000'1111'0000'1001, // 03 ISZ  0 9           ISZ CTR
-            0b0000'1100'0000'0001, // 04 JMP  0 1           JMP LOOP
-            0b0000'1011'0000'0111, // 05 STA  0 7           STA RES
-            0b0000'0000'0000'0000, // 06 HLT  x x           HLT
-            0b0000'0000'0000'0000, // 07 0 0 0  [RES]  <- Store result
-            0b0000'0000'0000'1010, // 08 0 0 A  [ANA]
-            0b0000'1111'1111'1010, // 09 F F A  [CTR] (-6)
-            0b0000'0000'0000'0001, // 10 0 0 1  [00A] (Adding numbers) <- first number
-            0b0000'0000'0000'0011, // 11 0 0 3
-            0b0000'0000'0000'0101, // 12 0 0 5
-            0b0000'0000'0000'0111, // 13 0 0 7
-            0b0000'0000'0000'1001, // 14 0 0 9
-            0b0000'0000'0000'1011, // 15 0 0 B  <- Last number
-            0b0000'0000'0000'0000 };
-
-*/
-
-/* Prog - 2
-        WORD prg[] = {
-            0b0000'0001'0000'0000, // 00 CRA x x    CRA
-            0b0000'1001'0000'0111, // 01 ADD 0 7    ADD SUB
-            0b0000'0010'0000'0000, // 02 CTA x x    CTA
-            0b0000'0011'0000'0000, // 03 ITA x x    ITA
-            0b0000'1001'0000'1000, // 04 ADD 0 8    ADD MIN
-            0b0000'1011'0000'1001, // 05 STA 0 9    STA DIF
-            0b0000'0000'0000'0000, // 06 HLT x x    HLT
-            0b0000'0000'1001'1100, // 07 0 9 C  [SUB]
-            0b0000'0000'1011'0111, // 08 0 B 7  [MIN]
-            0b0000'0000'0000'0000, // 09 x x x  [DIF]
-            0b0000'0000'0000'0000, // 10
-            0b0000'0000'0000'0000, // 11
-            0b0000'0000'0000'0000, // 12
-            0b0000'0000'0000'0000, // 13
-            0b0000'0000'0000'0000, // 14
-            0b0000'0000'0000'0000, // 15
-            0b0000'0000'0000'0000 };
-
-*/
-
-/*  Prog - 1
-        WORD prg[] = {
-            0b0000'0001'0000'0000, // 00 CRA x x
-            0b0000'1001'0000'0110, // 01 ADD 0 6
-            0b0000'1001'0000'0111, // 02 ADD 0 7
-            0b0000'1001'0000'1000, // 03 ADD 0 8
-            0b0000'1011'0000'1001, // 04 STA 0 9
-            0b0000'0000'0000'0000, // 05 HLT x x
-            0b0000'0000'0001'0111, // 06 0 1 7
-            0b0000'0000'0000'1011, // 07 0 0 B
-            0b0000'0000'0001'1100, // 08 0 1 C
-            0b0000'0000'0000'0000, // 09 x x x
-            0b0000'0000'0000'0000, // 10
-            0b0000'0000'0000'0000, // 11
-            0b0000'0000'0000'0000, // 12
-            0b0000'0000'0000'0000, // 13
-            0b0000'0000'0000'0000, // 14
-            0b0000'0000'0000'0000, // 15
-            0b0000'0000'0000'0000 };
-
-*/
-
-
-        n_size = sizeof(prg)/sizeof(WORD);
-        std::cout << "\n****** WORD n_size ****** : " << (int)n_size << "\n";
-
-        for (int i = 0; i < n_size; i++) // load program to memory
+        for (int k = 0; k < 4; k++)
         {
-            mStore[i] =  prg[i];
-            std::cout << mStore[i] << " - " ;
+            BenchResult res = {};
+            res.program = Variants[v].name;
+            res.engine = paths[k];
+            res.instructions = 1;       // BenchMeasure's ns/instruction becomes ns/run
+            BenchMeasure([&]() {
+                if (k == 0)             // the constructor alone, default program included
+                {
+                    std::unique_ptr<Computer> c(new Computer(cpu.Layout(), (MachineVariant)v));
+                    sink += c->Cycles();
+                }
+                else if (k == 1)        // a new machine as a one-shot batch job gets it
+                {
+                    std::unique_ptr<Computer> c(new Computer(cpu.Layout(), (MachineVariant)v));
+                    c->Load(image.data(), image.size());
+                    res.cycles = FirstInstruction(*c);
+                    ok &= (c->Counters().instructions == 1);
+                }
+                else if (k == 2)        // a worker's machine reused for the next job (BatchRunner)
+                {
+                    warm.Load(image.data(), image.size());
+                    res.cycles = FirstInstruction(warm);
+                }
+                else                    // the instruction interpreter, for scale
+                {
+                    std::unique_ptr<FastCpu> f(new FastCpu);
+                    f->Load(image.data(), image.size());
+                    f->Reset();
+                    f->Step();
+                    res.cycles = f->Cycles();
+                }
+            }, samples, res);
+
+            std::cout << std::left << std::setw(10) << res.program << std::setw(13) << res.engine << std::setw(8) << res.cycles
+                      << std::fixed << std::setprecision(1) << std::setw(9) << res.nsMin << std::setw(9) << res.nsMedian
+                      << std::setw(9) << res.nsMean << "+- " << std::setw(12) << res.nsStddev
+                      << std::defaultfloat << std::setprecision(6) << res.allocsPerRun << "\n" << std::right;
         }
-	}
+    }
+    return ok && sink == 0;
+}
 
-    void HighLevel()
-	{
-		if (mControlBus & mOutMask)
-		{
-			mDataBus = mStore[mMAR->Get()];		// RAM -> BUS
-		}
-	}
+void RunBatch(Computer& cpu, size_t count, Engine engine, unsigned threads)  // --batch: the loaded image count times
+{
+    std::vector<BatchJob> jobs(count);
+    for (auto& j : jobs)
+    {
+        j.image.assign(cpu.Ram().Data(), cpu.Ram().Data() + cpu.Ram().Size());
+        j.maxCycles = 1000000;
+        j.engine = engine;
+    }
 
-	void LowLevel()
-	{
-	    if (mControlBus & mInMask)
-		{
-            mStore[mMAR->Get()] = mDataBus;	     // BUS -> RAM																																	// 0x0000-0x7fff: schreiben in RAM
-		}
-		DisplayMemory();
-	}
+    BatchRunner runner(threads, cpu.Variant());
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<BatchResult> results = runner.Run(jobs);
+    auto t1 = std::chrono::steady_clock::now();
+    double secs = std::chrono::duration<double>(t1 - t0).count();
 
-	void Set(WORD& data)
+    uint64_t cycles = 0;
+    size_t halted = 0;
+    for (auto& r : results)
     {
-        mStore[mMAR->Get()] = data;
+        cycles += r.cycles;
+        halted += r.halted;
     }
 
-    WORD Get()
+    std::cout << "\n****** BATCH ****** " << count << " jobs on " << runner.Threads() << " threads\n";
+    std::cout << "halted       : " << halted << "\n";
+    std::cout << "seconds      : " << secs << "\n";
+    std::cout << "jobs/sec     : " << ((secs > 0.0) ? count / secs : 0.0) << "\n";
+    std::cout << "cycles/sec   : " << ((secs > 0.0) ? cycles / secs : 0.0) << "\n";
+    if (!results.empty())
     {
-        return mStore[mMAR->Get()];
+        std::cout << "job 0 Acc    : " << results[0].regs[5] << "\n";
     }
+}
 
-    void DisplayMemory()
-    {
-        std::cout << "\n****** WORD n_size ****** : " << (int)n_size << "\n";
+bool RunFuzz(size_t count, uint64_t seed, Engine engine, unsigned threads)  // --fuzz: count ProgramFuzzer images on the batch runner
+{
+    ProgramFuzzer fuzzer;
+    std::vector<BatchJob> jobs(count);
+    std::vector<uint64_t> bounds(count);
 
-        for (int i = 0; i < n_size; i++)
+    auto t0 = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; i++)
+    {
+        bounds[i] = fuzzer.Generate(seed + i, jobs[i].image);
+        jobs[i].maxCycles = 8 * bounds[i];     // every instruction takes at most 8 clocks
+        jobs[i].engine = engine;
+    }
+    auto t1 = std::chrono::steady_clock::now();
+
+    BatchRunner runner(threads);
+    std::vector<BatchResult> results = runner.Run(jobs);
+    auto t2 = std::chrono::steady_clock::now();
+    double gen = std::chrono::duration<double>(t1 - t0).count();
+    double secs = std::chrono::duration<double>(t2 - t1).count();
+
+    uint64_t cycles = 0;
+    uint64_t instructions = 0;
+    size_t failed = 0;
+    std::vector<size_t> order(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        cycles += results[i].cycles;
+        instructions += results[i].instructions;
+        order[i] = i;
+        if (!results[i].halted || results[i].instructions > bounds[i])
         {
-            std::cout << mStore[i] << " - " ;
+            std::cout << "seed " << (seed + i) << ": " << (results[i].halted ? "ran past its bound" : "did not halt") << "\n";
+            failed++;
         }
     }
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return results[a].cycles > results[b].cycles; });
+
+    std::cout << "\n****** FUZZ ****** " << count << " programs from seed " << seed << " on " << runner.Threads() << " threads\n";
+    std::cout << "generated/sec: " << ((gen > 0.0) ? count / gen : 0.0) << "\n";
+    std::cout << "instructions : " << instructions << "\n";
+    std::cout << "instr/sec    : " << ((secs > 0.0) ? instructions / secs : 0.0) << "\n";
+    std::cout << "cycles/sec   : " << ((secs > 0.0) ? cycles / secs : 0.0) << "\n";
+    std::cout << "failed       : " << failed << "\n";
+    for (size_t i = 0; i < order.size() && i < 3; i++)
+    {
+        std::cout << "longest      : seed " << (seed + order[i]) << ", " << results[order[i]].cycles << " clocks\n";
+    }
+    return failed == 0;
+}
 
-};
-
-
-
-/*******************************************************************************************************************
-
-                            INSTRUCTIONS [Fetch Cycle]
-    ------------------------------------------------------------------
-     Clock cycle    Microoperation             Explanation
-    ------------------------------------------------------------------
-        1           PC -> MAR       [PC_MAR]        Transfer instruction location
-                                                    from program counter to memory
-                                                    address register
-
-        2           M -> GPR        [M_GPR]         Transfer addressed word to
-                    PC+1 -> PC      [INCPC]         general-purpose register: increment
-                                                    program counter
-
-        3           GPR(OP) -> OPR  [GPR_OP]        Transfer operation part of
-                                                    instruction to operation register
-    ----------------------------------------------------------------------
-
-     INSTRUCTIONS [Execute Cycle]
-    ------------------------------------------------------------------------
-     Mnemonic      Explanation                         Microoperation
-    ------------------------------------------------------------------------
-        CRA        Clear accumulator                    0 -> Acc        [CLRA]
-                                                        0 -> SC         [CLRSC]  -  Clear Sequence Counter (2 clock cycle)
-
-        CTA        Complement accumulator               ~Acc -> Acc     [COMA]
-                                                        0 -> SC         [CLRSC]
-
-        ITA        Increment accumulator                Acc + 1 -> Acc  [INCA]
-                                                        0 -> SC         [CLRSC]
-
-        CRF        Clear flip-flop F                    0 -> F          [CLRF]
-                                                        0 -> SC         [CLRSC]
-
-        CTF        Complement flip-flop F               ~F -> F         [COMF]
-                                                        0 -> SC         [CLRSC]
-
-        SFZ         Skip next instruction               PC + 1 -> PC    [INCPCF]  (if F = 0)
-                        if F is zero                    0 -> SC         [CLRSC]
-
-
-        ROR         Rotate right through                Rotate right    [ROR]
-                        F and Acc                       0 -> SC         [CLRSC]
-
-        ROL         Rotate left through                 Rotate left     [ROL]
-                        F and Acc                       0 -> SC         [CLRSC]
-
-        HLT         HALT                                HLT             [HLT]
-    ------------------------------------------------------------------------
-
-
-    INSTRUCTIONS [Execute Cycle]
-    ------------------------------------------------------------------------
-     Mnemonic               Clock cycle            Microoperation
-    ------------------------------------------------------------------------
-    ADD ,Address    :           1                   GPR(AD) -> MAR      [GPR_MAR]
-
-                                2                   M > GPR            [M_GPR]
-
-                                3                   GPR + Acc -> Acc    [ADD]
-
-                                4                   0 -> SC             [CLRSC]
-    ------------------------------------------------------------------------
-
-    INSTRUCTIONS [Execute Cycle]
-    ------------------------------------------------------------------------
-     Mnemonic               Clock cycle            Microoperation
-    ------------------------------------------------------------------------
-    ADDI ,Address    :          1                   GPR(AD) -> MAR      [GPR_MAR]
-
-                                2                   M > GPR            [M_GPR]
-
-                                3                   GPR(AD) -> MAR      [GPR_MAR]
-
-                                4                   M > GPR            [M_GPR]
-
-                                5                   GPR + Acc -> Acc    [ADD]
-
-                                6                   0 -> SC             [CLRSC]
-    ------------------------------------------------------------------------
-
-    INSTRUCTIONS [Execute Cycle]
-    ------------------------------------------------------------------------
-     Mnemonic               Clock cycle            Microoperation
-    ------------------------------------------------------------------------
-    STA ,Address    :           1                   GPR(AD) -> MAR      [GPR_MAR]
-
-                                2                   Acc > GPR          [A_GPR]
-
-                                3                   GPR -> M            [GPR_M]
-
-                                4                   0 -> SC             [CLRSC]
-    ------------------------------------------------------------------------
-
-    INSTRUCTIONS [Execute Cycle]
-    ------------------------------------------------------------------------
-     Mnemonic               Clock cycle            Microoperation
-    ------------------------------------------------------------------------
-    JMP ,Address    :           1                   GPR(AD) -> PC       [GPR_PC]
-
-                                2                   0 -> SC             [CLRSC]
-    ------------------------------------------------------------------------
-
-    INSTRUCTIONS [Execute Cycle]
-    ------------------------------------------------------------------------
-     Mnemonic               Clock cycle            Microoperation
-    ------------------------------------------------------------------------
-    JMPI ,Address    :          1                   GPR(AD) -> MAR      [GPR_MAR]
-
-                                2                   M > GPR            [M_GPR]
-
-                                3                   GPR(AD) -> PC       [GPR_PC]
-
-                                4                   0 -> SC             [CLRSC]
-    ------------------------------------------------------------------------
-
-    INSTRUCTIONS [Execute Cycle]
-    ------------------------------------------------------------------------
-     Mnemonic               Clock cycle            Microoperation
-    ------------------------------------------------------------------------
-    CSR ,Address    :           1                   GPR(AD) -> MAR      [GPR_MAR]
+bool RunCores(Computer& cpu, unsigned cores, uint64_t quantum, const std::vector<WORD>& entry, unsigned threads, uint64_t budget)  // --cores
+{
+    std::vector<WORD> image(cpu.Ram().Size());
+    MultiComputer smp(cores, threads, cpu.Layout(), cpu.Variant());
+
+    cpu.ReadMem(0, image.size(), image.data());
+    smp.Load(image.data(), image.size());
+    smp.SetQuantum(quantum);
+    smp.Start(entry);
+
+    auto t0 = std::chrono::steady_clock::now();
+    RunStatus status = smp.Run(budget);
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    uint64_t clocks = 0;
+
+    for (size_t i = 0; i < smp.Cores(); i++) clocks += smp.Cpu(i).Cycles();
+    smp.Display(std::cout);
+    std::cout << "seconds      : " << secs << "\n";
+    std::cout << "core clocks/s: " << (secs > 0.0 ? clocks / secs : 0.0) << "\n";
+    return status == RUN_HALTED;
+}
 
-                                2                   GPR(AD) -> PC       [GPR_PC]
-                                                    PC -> GPR(AD)       [PC_GPR]
+bool RunSweep(Computer& cpu, size_t count, WORD addr)   // --sweep: count runs of the image, run i with word addr = i
+{
+    std::vector<WORD> image(cpu.Ram().Data(), cpu.Ram().Data() + cpu.Ram().Size());
+    std::vector<WORD> regs(count * 7);
+    std::vector<uint64_t> cycles(count);
+    std::vector<WORD> mem(256);
+    LaneCpu lanes;
+    FastCpu fast;
+    uint64_t steps = 0;
+    uint64_t laneSteps = 0;
+    size_t halted = 0;
+    size_t mismatches = 0;
+
+    lanes.Load(image.data(), image.size());
+    auto t0 = std::chrono::steady_clock::now();
+    for (size_t base = 0; base < count; base += LANES)
+    {
+        lanes.Reload();
+        for (int l = 0; l < LANES; l++)
+        {
+            lanes.SetWord(l, addr, (WORD)((base + l) & 0x0fff));
+        }
+        lanes.Reset();
+        lanes.Run(SWEEP_MAX_CYCLES);
+        steps += lanes.Steps();
+        laneSteps += lanes.LaneSteps();
+        for (int l = 0; l < LANES && base + l < count; l++)
+        {
+            lanes.ReadRegs(l, &regs[(base + l) * 7]);
+            cycles[base + l] = lanes.Cycles(l);
+            halted += lanes.Halted(l);
+        }
+    }
+    auto t1 = std::chrono::steady_clock::now();
 
-                                3                   GPR(AD) -> M        [GPR_M]
+    for (size_t i = 0; i < count; i++)  // the same runs one at a time, also the reference for every lane
+    {
+        WORD r[7];
+        fast.Load(image.data(), image.size());
+        fast.State().mem[addr] = (WORD)(i & 0x0fff);
+        fast.Reset();
+        fast.Run(SWEEP_MAX_CYCLES);
+        fast.ReadRegs(r);
+        mismatches += (memcmp(r, &regs[i * 7], sizeof(r)) != 0 || fast.Cycles() != cycles[i]);
+    }
+    auto t2 = std::chrono::steady_clock::now();
 
-                                4                   PC + 1 -> PC        [INCPC]
+    for (size_t base = 0; base < count && base < 4 * LANES; base += LANES)  // memory of the first batches
+    {
+        lanes.Reload();
+        for (int l = 0; l < LANES; l++)
+        {
+            lanes.SetWord(l, addr, (WORD)((base + l) & 0x0fff));
+        }
+        lanes.Reset();
+        lanes.Run(SWEEP_MAX_CYCLES);
+        for (int l = 0; l < LANES && base + l < count; l++)
+        {
+            fast.Load(image.data(), image.size());
+            fast.State().mem[addr] = (WORD)((base + l) & 0x0fff);
+            fast.Reset();
+            fast.Run(SWEEP_MAX_CYCLES);
+            lanes.ReadMem(l, mem.data());
+            mismatches += (memcmp(mem.data(), fast.State().mem, 256 * sizeof(WORD)) != 0);
+        }
+    }
 
-                                5                   0 -> SC             [CLRSC]
-    ------------------------------------------------------------------------
+    double lockstep = std::chrono::duration<double>(t1 - t0).count();
+    double single = std::chrono::duration<double>(t2 - t1).count();
+
+    std::cout << "\n****** SWEEP ****** " << count << " runs, word " << addr << " = 0.." << (count - 1) << ", "
+              << LANES << " lanes\n";
+    std::cout << "halted          : " << halted << "\n";
+    std::cout << "lane utilization: " << (steps ? laneSteps / (double)(steps * LANES) : 0.0) << "\n";
+    std::cout << "lockstep runs/s : " << ((lockstep > 0.0) ? count / lockstep : 0.0) << "\n";
+    std::cout << "single runs/s   : " << ((single > 0.0) ? count / single : 0.0) << "\n";
+    std::cout << "speed-up        : " << ((lockstep > 0.0) ? single / lockstep : 0.0) << "x\n";
+    std::cout << "mismatches      : " << mismatches << "\n";
+    if (count > 0)
+    {
+        std::cout << "run 0 Acc       : " << regs[5] << "\n";
+    }
+    return mismatches == 0;
+}
 
-    INSTRUCTIONS [Execute Cycle]
-    ------------------------------------------------------------------------
-     Mnemonic               Clock cycle            Microoperation
-    ------------------------------------------------------------------------
-    ISZ ,Address    :           1                   GPR(AD) -> MAR      [GPR_MAR]
+void DisplaySymbols(ProgramImage& image, const WORD* mem, WORD size)
+{
+    for (const Symbol& s : image.Symbols())
+    {
+        if (s.addr < size)
+        {
+            std::cout << s.name << " [" << s.addr << "] = " << mem[s.addr] << "\n";
+        }
+    }
+}
 
-                                2                   M -> GPR            [M_GPR]
+void DisplaySymbols(ProgramImage& image, Memory& ram)     // any Geometry
+{
+    for (const Symbol& s : image.Symbols())
+    {
+        if (s.addr < ram.Size())
+        {
+            std::cout << s.name << " [" << s.addr << "] = " << ram.Read(s.addr) << "\n";
+        }
+    }
+}
 
-                                3                   GPR + 1 -> GPR      [INCGPR]
+void DisplayProfile(Computer& cpu, const std::vector<Symbol>* symbols, std::ostream& folded)    // --profile
+{
+    Profiler profiler;
+    profiler.Analyze(cpu, symbols);
+    profiler.Display(std::cout);
+    if (folded)
+    {
+        profiler.WriteFolded(folded);
+    }
+}
 
-                                4                   GPR -> M            [GPR_M]
+bool OpenTraceOut(Computer& cpu, TraceWriter& writer, const char* path) // --trace-out: stream from the current cycle on
+{
+    if (!writer.Open(path, cpu.Cycles()))
+    {
+        std::cout << "cannot write " << path << "\n";
+        return false;
+    }
+    cpu.Trace().SetWriter(&writer);
+    return true;
+}
 
-                                5                   PC + 1 -> PC        [INCPCZ] (if GPR = 0 or Z = 1)
+bool CloseTraceOut(Computer& cpu, TraceWriter& writer, const char* path)
+{
+    cpu.Trace().SetWriter(nullptr);
+    bool written = writer.Close();
+    std::cout << "\n****** TRACE OUT ****** " << writer.Records() << " records, " << writer.Bytes() << " bytes ("
+              << (writer.Records() ? writer.Bytes() / (double)writer.Records() : 0.0) << " per clock) to " << path << "\n";
+    if (!written)
+    {
+        std::cout << "cannot write " << path << "\n";
+    }
+    return written;
+}
 
-                                6                   0 -> SC             [CLRSC]
-    ------------------------------------------------------------------------
+bool DecodeTrace(const char* path, uint64_t limit)  // --trace-decode: one line per clock of a --trace-out file
+{
+    TraceReader reader;
+    TraceFrame f;
+    uint64_t records = 0;
 
-*******************************************************************************************************************/
+    if (!reader.Open(path))
+    {
+        std::cout << path << ": " << reader.Error() << "\n";
+        return false;
+    }
+    while (reader.Next(f))
+    {
+        if (records++ < limit)
+        {
+            std::cout << "[" << f.cycle << "] SC " << f.regs[REG_SC] << "  OPR " << f.regs[REG_OPR] << "  PC " << f.regs[REG_PC]
+                      << "  MAR " << f.regs[REG_MAR] << "  GPR " << f.regs[REG_GPR] << "  Acc " << f.regs[REG_ACC]
+                      << "  F " << f.regs[REG_F] << "  Bus " << f.bus << "  Control " << f.control << "\n";
+        }
+    }
+    std::cout << "\n****** TRACE DECODE ****** " << records << " records" << (records > limit ? " (shown " : "");
+    if (records > limit) std::cout << limit << ")";
+    std::cout << ", last cycle " << (records ? f.cycle : 0) << "\n";
+    if (reader.Error())
+    {
+        std::cout << path << ": " << reader.Error() << "\n";
+        return false;
+    }
+    return true;
+}
 
-class Control : public Component
+class StreamPort : public IoPort        // --io: input words read from a text stream, results printed per block
 {
 private:
-
-	BYTE mOpcode;
-	BYTE mHltBit;
-	BYTE mFlagZ;
-    BYTE mFlagF;
-	WORD& mDataBus;                     // reference to the IO lines the component is connected to
-    DWORD& mControlBus;                  // reference to the control word
-	std::shared_ptr<Register> mRegOpr, mRegSteps, mRegFlg;
-	DWORD mMicrocode[136];
+    std::istream* mIn;                  // nullptr = no input
 
 public:
 
-    Control(WORD& port, DWORD& ctrl, std::shared_ptr<Register> opreg, std::shared_ptr<Register> sreg, std::shared_ptr<Register> flgreg)
-	: mDataBus(port), mControlBus(ctrl), mRegOpr(opreg), mRegSteps(sreg), mRegFlg(flgreg)
-	{
-// 0b[HLT][CLRSC][INCPCZ][INCPCF]0000000000[INCA][COMA][COMF][CLRF][ROL][ROR][CLRA][ADD][INCGPR][PC_GPR][A_GPR][M_GPR][GPR_OP][GPR_MAR][PC_MAR][GPR_PC][INCPC][GPR_M]
-        DWORD Microprg[] = {
-            0b00000000000000000000000000001000, //0 PC -> MAR               [PC_MAR]       .........................[FETCH]
-            0b00000000000000000000000001000010, //1 M -> GPR, PC+1 -> PC    [M_GPR][INCPC]     .....................[FETCH]
-            0b00000000000000000000000000100000, //2 GPR(OP) -> OPR          [GPR_OP]       .........................[FETCH]
-            0b00000000000000000000000000000000, //3
-            0b00000000000000000000000000000000, //4
-            0b00000000000000000000000000000000, //5
-            0b00000000000000000000000000000000, //6
-            0b00000000000000000000000000000000, //7
-            0b00000000000000000000100000000000, //8 <0001-CRA>  0 -> Acc    [CLRA]      ............................[EXECUTE]
-            0b01000000000000000000000000000000, //9 <0001-CRA>  0 -> SC     [CLRSC]     ............................[EXECUTE]
-            0b00000000000000000000000000000000, //10
-            0b00000000000000000000000000000000, //11
-            0b00000000000000000000000000000000, //12
-            0b00000000000000000000000000000000, //13
-            0b00000000000000000000000000000000, //14
-            0b00000000000000000000000000000000, //15
-            0b00000000000000010000000000000000, //16 <0010-CTA>  ~Acc -> Acc [COMA]      ...........................[EXECUTE]
-            0b01000000000000000000000000000000, //17 <0010-CTA>  0 -> SC     [CLRSC]     ...........................[EXECUTE]
-            0b00000000000000000000000000000000, //18
-            0b00000000000000000000000000000000, //19
-            0b00000000000000000000000000000000, //20
-            0b00000000000000000000000000000000, //21
-            0b00000000000000000000000000000000, //22
-            0b00000000000000000000000000000000, //23
-            0b00000000000000100000000000000000, //24 <0011-ITA>  Acc+1 -> Acc   [INCA]   ............................[EXECUTE]
-            0b01000000000000000000000000000000, //25 <0011-ITA>  0 -> SC        [CLRSC]   ...........................[EXECUTE]
-            0b00000000000000000000000000000000, //26
-            0b00000000000000000000000000000000, //27
-            0b00000000000000000000000000000000, //28
-            0b00000000000000000000000000000000, //29
-            0b00000000000000000000000000000000, //30
-            0b00000000000000000000000000000000, //31
-            0b00000000000000000100000000000000, //32 <0100-CRF>  0 -> F        [CLRF]   ............................[EXECUTE]
-            0b01000000000000000000000000000000, //33 <0100-CRF>  0 -> SC       [CLRSC]   ...........................[EXECUTE]
-            0b00000000000000000000000000000000, //34
-            0b00000000000000000000000000000000, //35
-            0b00000000000000000000000000000000, //36
-            0b00000000000000000000000000000000, //37
-            0b00000000000000000000000000000000, //38
-            0b00000000000000000000000000000000, //39
-            0b00000000000000001000000000000000, //40 <0101-CTF>  ~F -> F       [COMF]   ............................[EXECUTE]
-            0b01000000000000000000000000000000, //41 <0101-CTF>  0 -> SC       [CLRSC]   ...........................[EXECUTE]
-            0b00000000000000000000000000000000, //42
-            0b00000000000000000000000000000000, //43
-            0b00000000000000000000000000000000, //44
-            0b00000000000000000000000000000000, //45
-            0b00000000000000000000000000000000, //46
-            0b00000000000000000000000000000000, //47
-            0b00010000000000000000000000000000, //48 <0110-SFZ>  PC+1 -> PC    [INCPCF]  ...........................[EXECUTE]
-            0b01000000000000000000000000000000, //49 <0110-SFZ>  0 -> SC       [CLRSC]   ...........................[EXECUTE]
-            0b00000000000000000000000000000000, //50
-            0b00000000000000000000000000000000, //51
-            0b00000000000000000000000000000000, //52
-            0b00000000000000000000000000000000, //53
-            0b00000000000000000000000000000000, //54
-            0b00000000000000000000000000000000, //55
-            0b00000000000000000001000000000000, //56 <0111-ROR>  Rotate right  [ROR]   .............................[EXECUTE]
-            0b01000000000000000000000000000000, //57 <0111-ROR>  0 -> SC       [CLRSC]   ...........................[EXECUTE]
-            0b00000000000000000000000000000000, //58
-            0b00000000000000000000000000000000, //59
-            0b00000000000000000000000000000000, //60
-            0b00000000000000000000000000000000, //61
-            0b00000000000000000000000000000000, //62
-            0b00000000000000000000000000000000, //63
-            0b00000000000000000010000000000000, //64 <1000-ROL>  Rotate left  [ROL]   ..............................[EXECUTE]
-            0b01000000000000000000000000000000, //65 <1000-ROR>  0 -> SC      [CLRSC]   ............................[EXECUTE]
-            0b00000000000000000000000000000000, //66
-            0b00000000000000000000000000000000, //67
-            0b00000000000000000000000000000000, //68
-            0b00000000000000000000000000000000, //69
-            0b00000000000000000000000000000000, //70
-            0b00000000000000000000000000000000, //71
-            0b00000000000000000000000000010000, //72 <1001-ADD> GPR -> MAR     [GPR_MAR]  ..........................[EXECUTE]
-            0b00000000000000000000000001000000, //73 <1001-ADD> M > GPR       [M_GPR]  ............................[EXECUTE]
-            0b00000000000000000000010000000000, //74 <1001-ADD> GPR+Acc -> Acc [ADD]  ..............................[EXECUTE]
-            0b01000000000000000000000000000000, //75 <1001-ADD> 0 -> SC        [CLRSC]  ............................[EXECUTE]
-            0b00000000000000000000000000000000, //76
-            0b00000000000000000000000000000000, //77
-            0b00000000000000000000000000000000, //78
-            0b00000000000000000000000000000000, //79
-            0b00000000000000000000000000010000, //80 <1010-ADDI> GPR -> MAR     [GPR_MAR]  .........................[EXECUTE]
-            0b00000000000000000000000001000000, //81 <1010-ADDI> M > GPR       [M_GPR]  ...........................[EXECUTE]
-            0b00000000000000000000000000010000, //82 <1010-ADDI> GPR -> MAR     [GPR_MAR]  .........................[EXECUTE]
-            0b00000000000000000000000001000000, //83 <1010-ADDI> M > GPR       [M_GPR]  ...........................[EXECUTE]
-            0b00000000000000000000010000000000, //84 <1010-ADDI> GPR+Acc -> Acc [ADD]  .............................[EXECUTE]
-            0b01000000000000000000000000000000, //85 <1010-ADDI> 0 -> SC        [CLRSC]  ...........................[EXECUTE]
-            0b00000000000000000000000000000000, //86
-            0b00000000000000000000000000000000, //87
-            0b00000000000000000000000000010000, //88 <1011-STA> GPR -> MAR      [GPR_MAR]  .........................[EXECUTE]
-            0b00000000000000000000000010000000, //89 <1011-STA> Acc > GPR      [A_GPR]    .........................[EXECUTE]
-            0b00000000000000000000000000000001, //90 <1011-STA> GPR -> M        [GPR_M]    .........................[EXECUTE]
-            0b01000000000000000000000000000000, //91 <1011-STA> 0 -> SC         [CLRSC]   ..........................[EXECUTE]
-            0b00000000000000000000000000000000, //92
-            0b00000000000000000000000000000000, //93
-            0b00000000000000000000000000000000, //94
-            0b00000000000000000000000000000000, //95
-            0b00000000000000000000000000000100, //96 <1100-JMP> GPR -> PC       [GPR_PC]   .........................[EXECUTE]
-            0b01000000000000000000000000000000, //97 <1100-JMP> 0 -> SC         [CLRSC]   ..........................[EXECUTE]
-            0b00000000000000000000000000000000, //98
-            0b00000000000000000000000000000000, //99
-            0b00000000000000000000000000000000, //100
-            0b00000000000000000000000000000000, //101
-            0b00000000000000000000000000000000, //102
-            0b00000000000000000000000000000000, //103
-            0b00000000000000000000000000010000, //104 <1101-JMPI> GPR -> MAR    [GPR_MAR]  .........................[EXECUTE]
-            0b00000000000000000000000001000000, //105 <1101-JMPI> M > GPR      [M_GPR]  ...........................[EXECUTE]
-            0b00000000000000000000000000000100, //106 <1101-JMPI> GPR -> PC     [GPR_PC]   .........................[EXECUTE]
-            0b01000000000000000000000000000000, //107 <1101-JMPI> 0 -> SC       [CLRSC]   ..........................[EXECUTE]
-            0b00000000000000000000000000000000, //108
-            0b00000000000000000000000000000000, //109
-            0b00000000000000000000000000000000, //110
-            0b00000000000000000000000000000000, //111
-            0b00000000000000000000000000010000, //112 <1110-CSR> GPR -> MAR             [GPR_MAR]     ..............[EXECUTE]
-            0b00000000000000000000000100000000, //113 <1110-CSR> PC -> GPR              [PC_GPR]   .................[EXECUTE]
-            0b00000000000000000000000000000001, //114 <1110-CSR> GPR -> M               [GPR_M]    .................[EXECUTE]
-            0b00000000000000000000000000000010, //115 <1110-CSR> PC+1 -> PC             [INCPC]    .................[EXECUTE]
-            0b01000000000000000000000000000000, //116 <1110-CSR> 0 -> SC                [CLRSC]    .................[EXECUTE]
-            0b00000000000000000000000000000000, //117
-            0b00000000000000000000000000000000, //118
-            0b00000000000000000000000000000000, //119
-            0b00000000000000000000000000010000, //120 <1111-ISZ> GPR -> MAR          [GPR_MAR]  ....................[EXECUTE]
-            0b00000000000000000000000001000000, //121 <1111-ISZ> M -> GPR            [M_GPR]    ....................[EXECUTE]
-            0b00000000000000000000001000000000, //122 <1111-ISZ> GPR+1 -> GPR        [INCGPR]   ....................[EXECUTE]
-            0b00000000000000000000000000000001, //123 <1111-ISZ> GPR -> M            [GPR_M]    ....................[EXECUTE]
-            0b00100000000000000000000000000000, //124 <1111-ISZ> PC+1 -> PC          [INCPCZ]   ....................[EXECUTE]
-            0b01000000000000000000000000000000, //125 <1111-ISZ> 0 -> SC             [CLRSC]    ....................[EXECUTE]
-            0b00000000000000000000000000000000, //126
-            0b00000000000000000000000000000000, //127
-            0b10000000000000000000000000000000, //128 <10000-HLT> HLT                [HLT]      ....................[EXECUTE]
-            0b01000000000000000000000000000000, //129 <10000-HLT> 0 -> SC            [CLRSC]    ....................[EXECUTE]
-            0b00000000000000000000000000000000, //130
-            0b00000000000000000000000000000000, //131
-            0b00000000000000000000000000000000, //132
-            0b00000000000000000000000000000000, //133
-            0b00000000000000000000000000000000, //134
-            0b00000000000000000000000000000000, //135
-            };
-
-
-            BYTE n_size = sizeof(Microprg)/sizeof(DWORD);
-            std::cout << "\n****** WORD n_size ****** " << (int)n_size << "\n";
-
-            for (int i = 0; i < n_size; i++) // load Microcode to memory
-            {
-                mMicrocode[i] =  Microprg[i];
-                std::cout << (DWORD)mMicrocode[i] << " - " ;
-            }
-	}
-
-	void RisingEdge()
-	{
-        (mRegFlg->Get() & 0x01) ?  mFlagF = 1 : mFlagF = 0;
-        (mRegFlg->Get() & 0x02) ?  mFlagZ = 1 : mFlagZ = 0;
+    StreamPort(std::istream* in) : mIn(in)
+    {
+    }
 
-		if (mRegSteps->Get() > 2)
+    size_t Fill(WORD* words, size_t max)
+    {
+        size_t n = 0;
+        std::string w;
+        while (mIn && n < max && (*mIn >> w))
         {
-            mOpcode = (BYTE)(mRegOpr->Get());
-            (mOpcode == 0) ? mHltBit = 0b1000'0000 : mHltBit = 0b0000'0000;
-
-            mControlBus = mMicrocode[((mOpcode << 3) | mHltBit | (mRegSteps->Get()-3))];
-
+            words[n++] = (WORD)strtol(w.c_str(), nullptr, 0);
         }
-        else
+        return n;
+    }
+
+    void Drain(const WORD* words, size_t n)
+    {
+        std::cout << "\n****** I/O OUT ****** " << n << " words\n";
+        for (size_t i = 0; i < n; i++)
         {
-            mControlBus = mMicrocode[mRegSteps->Get()];
+            std::cout << words[i] << (((i + 1) % 16 == 0 || i + 1 == n) ? "\n" : " ");
         }
+    }
+};
 
-        if (mControlBus & INCPCF)				// SFZ
-		{
-			if (!mFlagF)
-            {
-                mControlBus |= INCPC;
-            }
-
-		}
-
-		if (mControlBus & INCPCZ)				// ISZ
-		{
-			if (mFlagZ)
-            {
-                mControlBus |= INCPC;
-            }
-
-		}
+bool ParseTraceLevel(const char* s, TraceLevel& level)
+{
+    const char* names[] = { "off", "instruction", "microstep", "bus" };
 
-        if (mControlBus & CLRSC)				// immediate asnychroneous reset
-		{
-			mRegSteps->Reset();
-			mControlBus = mMicrocode[0];
-		}
+    for (int i = 0; i < 4; i++)
+    {
+        if (strcmp(s, names[i]) == 0)
+        {
+            level = (TraceLevel)i;
+            return true;
+        }
+    }
+    return false;
+}
 
-		if (mControlBus & HLT)
-		{
-			exit(0);
-		}
+bool ParseSchedule(const char* s, Schedule& schedule)
+{
+    const char* names[] = { "dynamic", "static", "event" };
 
-		std::cout << "\nSeq Count ->" << mRegSteps->Get() << "\n";
-		std::cout << "\nOpCode ->" << (WORD)mOpcode << "\n";
-		std::cout << "\nControl Bus = " << mControlBus << "\n";
+    for (int i = 0; i < 3; i++)
+    {
+        if (strcmp(s, names[i]) == 0)
+        {
+            schedule = (Schedule)i;
+            return true;
+        }
+    }
+    return false;
+}
 
-	}
+bool ParseWatch(const char* s, Breakpoints& breaks)     // addr[:r|w|rw], both when omitted
+{
+    char* end;
+    WORD addr = (WORD)strtoul(s, &end, 0);
+    bool read = true, write = true;
 
-    void Reset()
+    if (end == s)
     {
-        //mControlBus = 0;
+        return false;
     }
+    if (*end == ':')
+    {
+        read = (strchr(end + 1, 'r') != nullptr);
+        write = (strchr(end + 1, 'w') != nullptr);
+    }
+    else if (*end)
+    {
+        return false;
+    }
+    if (!read && !write)
+    {
+        return false;
+    }
+    breaks.SetWatch(addr, read, write);
+    return true;
+}
 
-};
+bool ParseCondition(const char* s, Breakpoints& breaks)     // REG=value, REG one of RegNames[]
+{
+    const char* eq = strchr(s, '=');
 
+    for (int r = 0; eq && r < REG_COUNT; r++)
+    {
+        if (strlen(RegNames[r]) == (size_t)(eq - s) && strncmp(s, RegNames[r], eq - s) == 0)
+        {
+            breaks.AddCondition((BYTE)r, (WORD)strtoul(eq + 1, nullptr, 0));
+            return true;
+        }
+    }
+    return false;
+}
 
-class Computer
+int main(int argc, char* argv[])
 {
-protected:
-	uint32_t mLastTicks;
-	float mSimTime;
-    WORD mData;
-    WORD mBusLines;
-    DWORD mCtrlLines;
-    std::vector<std::shared_ptr<Component>> mComponents;
-    std::vector<std::shared_ptr<Register>> mRegisters;
 
-public:
-	Computer()
-	{
-
-        // 0b[HLT][CLRSC][INCPCZ][INCPCF]0000000000[INCA][COMA][COMF][CLRF][ROL][ROR][CLRA][ADD][INCGPR][PC_GPR][A_GPR][M_GPR][GPR_OP][GPR_MAR][PC_MAR][GPR_PC][INCPC][GPR_M]
+    std::cout << "\n**********************************  CPU   **********************************\n";
 
-        std::shared_ptr<Register> accReg = std::make_shared<Register>(mBusLines, mCtrlLines, 0, 0, INCA, 0x0fff);
-        std::shared_ptr<Register> gprReg = std::make_shared<Register>(mBusLines, mCtrlLines, (PC_GPR | M_GPR), (GPR_M | GPR_MAR | GPR_OP | GPR_PC), INCGPR, 0x0fff);
-        std::shared_ptr<Register> pcReg = std::make_shared<Register>(mBusLines, mCtrlLines, GPR_PC, (PC_MAR | PC_GPR), INCPC, 0x00ff);
-        std::shared_ptr<Register> flgReg = std::make_shared<Register>(mBusLines, mCtrlLines, 0, 0, 0, 0x0003);
-        std::shared_ptr<Register> marReg = std::make_shared<Register>(mBusLines, mCtrlLines, (PC_MAR | GPR_MAR), 0, 0, 0x00ff);
+	bool running = true;
+	bool fast = false;
+	Engine engine = ENGINE_MICROCODE;
+	Schedule schedule = SCHED_EVENT;
+	int benchRuns = 0;
+	int benchSamples = 0;
+	const char* benchOut = nullptr;
+	size_t batchJobs = 0;
+	unsigned threads = 0;
+	size_t sweepRuns = 0;
+	size_t cosimRuns = 0;
+	uint64_t cosimSeed = 1;
+	bool cosim = false;
+	bool cosimFuzz = false;
+	size_t fuzzRuns = 0;
+	uint64_t fuzzSeed = 1;
+	WORD sweepAddr = 19;
+	std::vector<const char*> images;
+	std::vector<std::string> assembled;
+	const char* saveImage = nullptr;
+	const char* asmOut = nullptr;
+	std::string cacheDir = getenv("TAUB_ASM_CACHE") ? getenv("TAUB_ASM_CACHE") : ".taub-cache";
+	uint64_t budget = UINT64_MAX;
+	TraceLevel level = TRACE_MICROSTEP;
+	Pacing pacing = PACE_PRECISE;
+	bool virtualTime = false;
+	bool levelSet = false;
+	int addrBits = ADDR_BITS;
+	uint64_t checkpointEvery = 0;
+	bool seek = false;
+	uint64_t seekCycle = 0;
+	const char* snapshotIn = nullptr;
+	const char* snapshotOut = nullptr;
+	bool changes = false;
+	Breakpoints breaks;
+	const char* traceOut = nullptr;
+	TraceWriter traceWriter;
+	uint64_t hz = CLOCK_HZ;
+	bool profile = false;
+	std::ofstream folded;
+	unsigned cores = 0;
+	uint64_t quantum = SMP_QUANTUM;
+	std::vector<WORD> entry;
+	int startupSamples = 0;
+	MachineVariant variant = VARIANT_CPU5;
+	const ReferenceProgram* program = nullptr;
+	bool io = false;
+	const char* ioIn = nullptr;
+
+	for (int i = 1; i < argc; i++)
+	{
+	    if (strcmp(argv[i], "--fast") == 0)                    // --fast [max cycles]
+	    {
+	        fast = true;
+	        if (i + 1 < argc && argv[i + 1][0] != '-') budget = strtoull(argv[++i], nullptr, 0);
+	    }
+	    else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc && ParseTraceLevel(argv[i + 1], level))
+	    {
+	        levelSet = true;                                    // --trace off|instruction|microstep|bus
+	        i++;
+	    }
+	    else if (strcmp(argv[i], "--engine") == 0 && i + 1 < argc
+	             && (strcmp(argv[i + 1], "microcode") == 0 || strcmp(argv[i + 1], "fast") == 0
+	                 || strcmp(argv[i + 1], "blocks") == 0))
+	    {
+	        i++;                                                // --engine microcode|fast|blocks
+	        engine = (strcmp(argv[i], "fast") == 0) ? ENGINE_FAST
+	               : (strcmp(argv[i], "blocks") == 0) ? ENGINE_BLOCKS : ENGINE_MICROCODE;
+	    }
+	    else if (strcmp(argv[i], "--bench-pipeline") == 0)      // --bench-pipeline [runs]
+	    {
+	        benchRuns = 10000;
+	        if (i + 1 < argc && argv[i + 1][0] != '-') benchRuns = atoi(argv[++i]);
+	    }
+	    else if (strcmp(argv[i], "--bench") == 0)               // --bench [samples] [--bench-out file.csv|file.json]
+	    {
+	        benchSamples = 15;
+	        if (i + 1 < argc && argv[i + 1][0] != '-') benchSamples = atoi(argv[++i]);
+	        if (benchSamples < 1) benchSamples = 1;
+	    }
+	    else if (strcmp(argv[i], "--bench-startup") == 0)       // --bench-startup [samples]
+	    {
+	        startupSamples = 15;
+	        if (i + 1 < argc && argv[i + 1][0] != '-') startupSamples = std::max(1, atoi(argv[++i]));
+	    }
+	    else if (strcmp(argv[i], "--variant") == 0 && i + 1 < argc && ParseVariant(argv[i + 1], variant))
+	    {
+	        i++;                                                // --variant cpu5|cpu2, see VARIANTS
+	    }
+	    else if (strcmp(argv[i], "--program") == 0 && i + 1 < argc && FindProgram(argv[i + 1]))
+	    {
+	        program = FindProgram(argv[++i]);                   // --program name of a ReferencePrograms[] entry
+	    }
+	    else if (strcmp(argv[i], "--bench-out") == 0 && i + 1 < argc)
+	    {
+	        benchOut = argv[++i];
+	    }
+	    else if (strcmp(argv[i], "--pace") == 0 && i + 1 < argc
+	             && (strcmp(argv[i + 1], "sleep") == 0 || strcmp(argv[i + 1], "precise") == 0
+	                 || strcmp(argv[i + 1], "virtual") == 0))
+	    {
+	        i++;                                                // --pace sleep|precise|virtual
+	        pacing = (strcmp(argv[i], "sleep") == 0) ? PACE_SLEEP : PACE_PRECISE;
+	        virtualTime = (strcmp(argv[i], "virtual") == 0);
+	    }
+	    else if (strcmp(argv[i], "--hz") == 0 && i + 1 < argc && strtoull(argv[i + 1], nullptr, 0) > 0)
+	    {
+	        hz = strtoull(argv[++i], nullptr, 0);               // --hz frequency of the paced run
+	    }
+	    else if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc)   // --batch jobs [--threads n]
+	    {
+	        batchJobs = strtoull(argv[++i], nullptr, 0);
+	    }
+	    else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+	    {
+	        threads = atoi(argv[++i]);
+	    }
+	    else if (strcmp(argv[i], "--sweep") == 0 && i + 1 < argc)   // --sweep runs [address], default NUMA
+	    {
+	        sweepRuns = strtoull(argv[++i], nullptr, 0);
+	        if (i + 1 < argc && argv[i + 1][0] != '-') sweepAddr = (WORD)(strtoul(argv[++i], nullptr, 0) & 0x00ff);
+	    }
+	    else if (strcmp(argv[i], "--addr-bits") == 0 && i + 1 < argc
+	             && atoi(argv[i + 1]) >= ADDR_BITS && atoi(argv[i + 1]) <= ADDR_BITS_MAX)
+	    {
+	        addrBits = atoi(argv[++i]);                         // --addr-bits 8-12, microcode engine only
+	    }
+	    else if (strcmp(argv[i], "--checkpoint") == 0 && i + 1 < argc)  // --checkpoint clocks [--seek cycle]
+	    {
+	        checkpointEvery = strtoull(argv[++i], nullptr, 0);
+	    }
+	    else if (strcmp(argv[i], "--seek") == 0 && i + 1 < argc)
+	    {
+	        seek = true;
+	        seekCycle = strtoull(argv[++i], nullptr, 0);
+	    }
+	    else if (strcmp(argv[i], "--snapshot") == 0 && i + 1 < argc)    // --snapshot file: resume instead of starting at reset
+	    {
+	        snapshotIn = argv[++i];
+	    }
+	    else if (strcmp(argv[i], "--save-snapshot") == 0 && i + 1 < argc)
+	    {
+	        snapshotOut = argv[++i];
+	    }
+	    else if (strcmp(argv[i], "--cosim") == 0 && i + 1 < argc)   // --cosim runs [seed]
+	    {
+	        cosim = true;
+	        cosimRuns = strtoull(argv[++i], nullptr, 0);
+	        if (i + 1 < argc && isdigit((BYTE)argv[i + 1][0])) cosimSeed = strtoull(argv[++i], nullptr, 0);
+	        if (i + 1 < argc && strcmp(argv[i + 1], "fuzz") == 0) cosimFuzz = true, i++;
+	    }
+	    else if (strcmp(argv[i], "--fuzz") == 0 && i + 1 < argc)    // --fuzz programs [seed], on --engine and --threads
+	    {
+	        fuzzRuns = strtoull(argv[++i], nullptr, 0);
+	        if (i + 1 < argc && argv[i + 1][0] != '-') fuzzSeed = strtoull(argv[++i], nullptr, 0);
+	    }
+	    else if (strcmp(argv[i], "--schedule") == 0 && i + 1 < argc && ParseSchedule(argv[i + 1], schedule))
+	    {
+	        i++;                                                // --schedule dynamic|event|static
+	    }
+	    else if (strcmp(argv[i], "--break") == 0 && i + 1 < argc)   // --break addr, may be repeated
+	    {
+	        breaks.SetPc((WORD)strtoul(argv[++i], nullptr, 0));
+	    }
+	    else if (strcmp(argv[i], "--watch") == 0 && i + 1 < argc && ParseWatch(argv[i + 1], breaks))
+	    {
+	        i++;                                                // --watch addr[:r|w|rw]
+	    }
+	    else if (strcmp(argv[i], "--break-if") == 0 && i + 1 < argc && ParseCondition(argv[i + 1], breaks))
+	    {
+	        i++;                                                // --break-if REG=value, e.g. Acc=104
+	    }
+	    else if (strcmp(argv[i], "--trace-out") == 0 && i + 1 < argc)  // --trace-out file: every clock, binary
+	    {
+	        traceOut = argv[++i];
+	    }
+	    else if (strcmp(argv[i], "--trace-decode") == 0 && i + 1 < argc)  // --trace-decode file [records]
+	    {
+	        const char* path = argv[++i];
+	        uint64_t limit = UINT64_MAX;
+	        if (i + 1 < argc && argv[i + 1][0] != '-') limit = strtoull(argv[++i], nullptr, 0);
+	        return DecodeTrace(path, limit) ? 0 : 1;
+	    }
+	    else if (strcmp(argv[i], "--profile") == 0)             // --profile [stacks.folded]
+	    {
+	        profile = true;
+	        if (i + 1 < argc && argv[i + 1][0] != '-')
+	        {
+	            folded.open(argv[++i], std::ios::trunc);
+	            if (!folded)
+	            {
+	                std::cout << "cannot write " << argv[i] << "\n";
+	                return 1;
+	            }
+	        }
+	    }
+	    else if (strcmp(argv[i], "--cores") == 0 && i + 1 < argc && atoi(argv[i + 1]) > 0)   // --cores n [quantum], --entry a,b,..
+	    {
+	        cores = (unsigned)std::min(atoi(argv[++i]), SMP_CORES_MAX);
+	        if (i + 1 < argc && argv[i + 1][0] != '-') quantum = strtoull(argv[++i], nullptr, 0);
+	    }
+	    else if (strcmp(argv[i], "--entry") == 0 && i + 1 < argc)
+	    {
+	        for (const char* p = argv[++i]; *p; p += (*p == ','))
+	        {
+	            char* end;
+	            entry.push_back((WORD)strtoul(p, &end, 0));
+	            if (end == p) break;
+	            p = end;
+	        }
+	    }
+	    else if (strcmp(argv[i], "--io") == 0)                  // --io [input words|-]: I/O window at the top of memory
+	    {
+	        io = true;
+	        if (i + 1 < argc && (argv[i + 1][0] != '-' || strcmp(argv[i + 1], "-") == 0)) ioIn = argv[++i];
+	    }
+	    else if (strcmp(argv[i], "--changes") == 0)             // dumps list only what changed
+	    {
+	        changes = true;
+	    }
+	    else if (strcmp(argv[i], "--image") == 0 && i + 1 < argc)    // --image file.img, may be repeated
+	    {
+	        images.push_back(argv[++i]);
+	    }
+	    else if (strcmp(argv[i], "--save-image") == 0 && i + 1 < argc)
+	    {
+	        saveImage = argv[++i];
+	    }
+	    else if (strcmp(argv[i], "--asm") == 0 && i + 1 < argc)      // --asm file.tasm, runs it like --image
+	    {
+	        Assembler as;
+	        std::string path;
+	        bool cached;
+	        if (!as.AssembleCached(argv[++i], cacheDir, path, cached))
+	        {
+	            std::cout << argv[i] << ": " << as.Error() << "\n";
+	            return 1;
+	        }
+	        std::cout << argv[i] << (cached ? " -> (cached) " : " -> ") << path << "\n";
+	        assembled.push_back(path);
+	    }
+	    else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc)         // --asm file.tasm -o out.img: copy and stop
+	    {
+	        asmOut = argv[++i];
+	    }
+	    else
+	    {
+	        std::cout << "usage: " << argv[0] << " [--fast [max cycles]] [--trace off|instruction|microstep|bus]"
+	                  << " [--variant cpu5|cpu2] [--program dbl-sum|multiply|subtract|ror-loop|rol-loop|add-list]"
+	                  << " [--engine microcode|fast|blocks] [--schedule dynamic|event|static] [--bench-pipeline [runs]] [--bench [samples] [--bench-out file]]"
+	                  << " [--bench-startup [samples]]"
+	                  << " [--batch jobs [--threads n]] [--sweep runs [address]] [--cosim runs [seed] [fuzz]] [--fuzz programs [seed]] [--pace sleep|precise|virtual] [--hz frequency] [--addr-bits 8-12]"
+	                  << " [--checkpoint clocks] [--seek cycle] [--snapshot file] [--save-snapshot file] [--changes]"
+	                  << " [--trace-out file] [--trace-decode file [records]] [--profile [file.folded]]"
+	                  << " [--cores n [quantum] [--entry addr,..] [--threads n]] [--io [input|-]]"
+	                  << " [--break addr] [--watch addr[:r|w|rw]] [--break-if REG=value]"
+	                  << " [--image file.img ...] [--save-image file.img] [--asm file.tasm ... [-o out.img]]\n";
+	        return 1;
+	    }
+	}
 
-        std::shared_ptr<Register> oprReg = std::make_shared<Register>(mBusLines, mCtrlLines, 0, 0, 0, 0x000f);
-        std::shared_ptr<Register> sReg = std::make_shared<Register>(mBusLines, mCtrlLines, 0, 0, 0xffff, 0x000f);	// always counting
+	if (addrBits != ADDR_BITS && (engine != ENGINE_MICROCODE || benchRuns || benchSamples || batchJobs || sweepRuns || cosim || fuzzRuns))
+	{
+	    std::cout << "--addr-bits needs the microcode engine; the instruction engines use the default geometry\n";
+	    return 1;
+	}
+	if ((traceOut || profile) && (engine != ENGINE_MICROCODE || benchRuns || benchSamples || batchJobs || sweepRuns || cosim || fuzzRuns))
+	{
+	    std::cout << (traceOut ? "--trace-out" : "--profile") << " needs a single run on the microcode engine\n";
+	    return 1;
+	}
+	if (io && (engine != ENGINE_MICROCODE || benchRuns || benchSamples || batchJobs || sweepRuns || cosim || fuzzRuns || cores))
+	{
+	    std::cout << "--io needs a single run on the microcode engine\n";
+	    return 1;
+	}
+	std::ifstream ioFile;
+	if (ioIn && strcmp(ioIn, "-") != 0)
+	{
+	    ioFile.open(ioIn);
+	    if (!ioFile)
+	    {
+	        std::cout << "cannot open " << ioIn << "\n";
+	        return 1;
+	    }
+	}
+	StreamPort ioPort(ioIn ? (ioFile.is_open() ? (std::istream*)&ioFile : &std::cin) : nullptr);
+	IoWindow window(&ioPort);
 
-        std::shared_ptr<GprBus> gBus = std::make_shared<GprBus>(mBusLines, mCtrlLines, (PC_GPR | GPR_OP), 0, pcReg, oprReg, gprReg);
-        std::shared_ptr<Adder> alu = std::make_shared<Adder>(mBusLines, mCtrlLines, (ADD | ROL | ROR | COMA | COMF | CLRA | CLRF | A_GPR), 0 , accReg, gprReg, flgReg);
-        std::shared_ptr<Memory> ram = std::make_shared<Memory>(mBusLines, mCtrlLines, GPR_M, M_GPR, marReg);
-        std::shared_ptr<Control> ctrl = std::make_shared<Control>(mBusLines, mCtrlLines, oprReg, sReg, flgReg);
+	if (addrBits != ADDR_BITS && images.empty() && assembled.empty())
+	{
+	    std::cout << "--addr-bits needs an --image or --asm program built for that width (BITS n); the built-in programs are 8-bit\n";
+	    return 1;
+	}
+	Computer cpu{ Geometry((BYTE)addrBits), variant };
+	if (program) cpu.LoadProgram(program->image, program->size);
+	cpu.DisplayMemory();                    // the variant's or --program's program, before an image replaces it
+	if (io) cpu.AttachIo(&window);
+	cpu.Breaks() = breaks;
+	cpu.SetSchedule(schedule);
+	cpu.SetProfiling(profile);
+
+	if (asmOut)
+	{
+	    std::error_code ec;
+	    if (assembled.size() != 1)
+	    {
+	        std::cout << "-o needs exactly one --asm source\n";
+	        return 1;
+	    }
+	    std::filesystem::copy_file(assembled[0], asmOut, std::filesystem::copy_options::overwrite_existing, ec);
+	    std::filesystem::copy_file(assembled[0] + ".sym", std::string(asmOut) + ".sym", std::filesystem::copy_options::overwrite_existing, ec);
+	    return ec ? 1 : 0;
+	}
+	for (const std::string& path : assembled)
+	{
+	    images.push_back(path.c_str());
+	}
 
+	if (saveImage)                          // writes the built-in program in image format
+	{
+	    return ProgramImage::Save(saveImage, cpu.Ram().Data(), cpu.Ram().Size()) ? 0 : 1;
+	}
 
-        mComponents.emplace_back(sReg);
-        mComponents.emplace_back(pcReg);
-        mComponents.emplace_back(accReg);
-        mComponents.emplace_back(gprReg);
-        mComponents.emplace_back(flgReg);
-        mComponents.emplace_back(oprReg);
-        mComponents.emplace_back(marReg);
-        mComponents.emplace_back(gBus);
-        mComponents.emplace_back(alu);
-        mComponents.emplace_back(ram);
-        mComponents.emplace_back(ctrl);
+	if (images.size() > 1 || (images.size() == 1 && batchJobs == 0 && sweepRuns == 0 && !cosim && cores == 0))
+	{
+	    ProgramImage image;                 // every image runs free on the same warm Computer
+	    FastCpu fastCpu;
+
+	    cpu.Trace().SetLevel(levelSet ? level : TRACE_OFF);
+	    if (traceOut && !OpenTraceOut(cpu, traceWriter, traceOut))
+	    {
+	        return 1;
+	    }
+	    for (const char* path : images)
+	    {
+	        if (!image.Open(path))
+	        {
+	            std::cout << "cannot open " << path << "\n";
+	            return 1;
+	        }
+	        if (!cpu.LoadProgram(image))
+	        {
+	            std::cout << "\n" << path << " was built for BITS " << (int)image.Bits() << ", run it with --addr-bits " << (int)image.Bits() << "\n";
+	            return 1;
+	        }
+	        cpu.Reset();
+
+	        std::cout << "\n****** " << path << " ******\n";
+	        if (engine != ENGINE_MICROCODE)
+	        {
+	            fastCpu.SetBlockCache(engine == ENGINE_BLOCKS);
+	            fastCpu.Load(cpu.Ram().Data(), cpu.Ram().Size());
+	            fastCpu.Reset();
+	            fastCpu.Run(budget);
+	            fastCpu.DisplayRegs();
+	            DisplaySymbols(image, fastCpu.State().mem, 256);
+	        }
+	        else
+	        {
+	            cpu.Run(budget);
+	            cpu.Trace().Dump(std::cout);
+	            cpu.DisplayRegs();
+	            DisplaySymbols(image, cpu.Ram());
+	            if (profile) DisplayProfile(cpu, &image.Symbols(), folded);
+	            if (io)
+	            {
+	                window.Flush();
+	                window.Display(cpu.Ram().IoBase());
+	            }
+	        }
+	    }
+	    return (traceOut && !CloseTraceOut(cpu, traceWriter, traceOut)) ? 1 : 0;
+	}
 
-        mRegisters.emplace_back(sReg);
-        mRegisters.emplace_back(pcReg);
-        mRegisters.emplace_back(marReg);
-        mRegisters.emplace_back(oprReg);
-        mRegisters.emplace_back(gprReg);
-        mRegisters.emplace_back(accReg);
-        mRegisters.emplace_back(flgReg);
+	if (images.size() == 1)                 // --batch or --sweep with one image
+	{
+	    ProgramImage image;
+	    if (!image.Open(images[0]))
+	    {
+	        std::cout << "cannot open " << images[0] << "\n";
+	        return 1;
+	    }
+	    if (!cpu.LoadProgram(image))
+	    {
+	        std::cout << "\n" << images[0] << " was built for BITS " << (int)image.Bits() << ", run it with --addr-bits " << (int)image.Bits() << "\n";
+	        return 1;
+	    }
+	}
 
+	if (batchJobs > 0)
+	{
+	    RunBatch(cpu, batchJobs, engine, threads);
+	    return 0;
+	}
 
+	if (sweepRuns > 0)
+	{
+	    return RunSweep(cpu, sweepRuns, sweepAddr) ? 0 : 1;
+	}
 
-		Reset();
+	if (cores > 0)
+	{
+	    return RunCores(cpu, cores, quantum, entry, threads, budget) ? 0 : 1;
+	}
 
+	if (cosim)
+	{
+	    return RunCoSim(cpu, cosimRuns, cosimSeed, cosimFuzz) ? 0 : 1;
 	}
 
-	void Reset()
+	if (fuzzRuns > 0)
 	{
-		for (auto& c : mComponents) c->Reset();
-		mSimTime = 0.0f;
-		mLastTicks = GetTickCount();
+	    return RunFuzz(fuzzRuns, fuzzSeed, engine, threads) ? 0 : 1;
 	}
 
-	void Update()
+	if (startupSamples > 0)
 	{
-		uint32_t nowticks = GetTickCount();
-		mSimTime += (nowticks - mLastTicks)*0.001f;
-		mLastTicks = nowticks;
-		while (mSimTime > 1.0f / 1843200.0f)
-		{
-			for(auto& c : mComponents) c->RisingEdge();
-            for(auto& c : mComponents) c->HighLevel();
-            for(auto& c : mComponents) c->FallingEdge();
-            for(auto& c : mComponents) c->LowLevel();
-
-            for(auto& c : mRegisters)
-            {
-                std::cout << "\nReg -> " << c->Get() << "\n";
-            }
+	    return BenchStartup(cpu, startupSamples) ? 0 : 1;
+	}
 
-			mSimTime -= 1.0f / 1843200.0f;
-		}
+	if (benchSamples > 0)
+	{
+	    return Bench(cpu, benchSamples, benchOut) ? 0 : 1;
 	}
 
-	void DisplayRegs()
+	if (benchRuns > 0)
 	{
-	    for(auto& c : mRegisters)
-        {
-            std::cout << "\nReg -> " << c->Get() << "\n";
-        }
+	    BenchPipeline(cpu, benchRuns);
+	    return 0;
 	}
-};
 
+	if (engine != ENGINE_MICROCODE)         // the interpreter has no wall-clock pacing and no trace
+	{
+	    RunFast(cpu, budget, engine == ENGINE_BLOCKS);
+	    return 0;
+	}
 
-int main()
-{
+	SteadyClock steadyClock(pacing);
+	VirtualClock virtualClock;
+	cpu.SetClock(virtualTime ? (ClockSource*)&virtualClock : &steadyClock);
+	cpu.SetFrequency(hz);
+	cpu.Trace().SetLevel((fast && !levelSet) ? TRACE_OFF : level);
+	cpu.Reset();
+	cpu.SetCheckpoints(checkpointEvery);
+	if (snapshotIn)
+	{
+	    Snapshot snap;
+	    if (!snap.Load(snapshotIn) || !cpu.RestoreSnapshot(snap))
+	    {
+	        std::cout << "cannot restore " << snapshotIn << "\n";
+	        return 1;
+	    }
+	}
+	if (traceOut && !OpenTraceOut(cpu, traceWriter, traceOut))
+	{
+	    return 1;
+	}
 
-    std::cout << "\n**********************************  CPU   **********************************\n";
+	if (fast)
+	{
+	    RunFree(cpu, budget);
+	}
+	else
+	{
+	    uint64_t slice = cpu.Clock().Now();
+	    auto t0 = std::chrono::steady_clock::now();
+	    while (running)
+	    {
+		    RunStatus status = cpu.Update();
+		    running = (status != RUN_HALTED);
+		    if (status == RUN_BREAK)
+		    {
+			    cpu.DisplayBreak(std::cout);
+			    continue;                   // the same slice goes on after the breakpoint
+		    }
+		    if (changes) cpu.DisplayChanges(std::cout);
+		    slice += PACE_SLICE_NS;
+		    cpu.Clock().WaitUntil(slice);
+	    }
+	    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+	    std::cout << "\n****** PACED RUN ****** " << cpu.Cycles() << " clocks, "
+	              << cpu.Cycles() / (double)hz << " s emulated, " << secs << " s wall\n";
+	    cpu.Pacing().Display(std::cout);
+	}
+	if (traceOut && !CloseTraceOut(cpu, traceWriter, traceOut))    // before --seek, which would replay into the stream
+	{
+	    return 1;
+	}
 
-    Computer cpu;
-	bool running = true;
-	cpu.Reset();
-	while (running)
+	cpu.Trace().Dump(std::cout, changes);   // formatting happens here, after the run
+	if (seek)
+	{
+	    bool reached = cpu.Seek(seekCycle);
+	    std::cout << "\n****** SEEK ****** cycle " << cpu.Cycles() << (reached ? "" : " (halted before)")
+	              << ", " << cpu.Checkpoints() << " checkpoints\n";
+	    if (fast) cpu.DisplayRegs();    // otherwise shown below
+	}
+	if (snapshotOut)
+	{
+	    Snapshot snap;
+	    cpu.SaveSnapshot(snap);
+	    if (!snap.Save(snapshotOut))
+	    {
+	        std::cout << "cannot write " << snapshotOut << "\n";
+	        return 1;
+	    }
+	}
+	if (changes)
+	{
+	    cpu.DisplayChanges(std::cout);
+	}
+	else if (!fast)
+	{
+	    cpu.DisplayRegs();
+	    cpu.DisplayMemory();
+	}
+	DisplayCounters(cpu.Counters(), std::cout);
+	if (profile)
+	{
+	    DisplayProfile(cpu, nullptr, folded);
+	}
+	if (io)
 	{
-        cpu.Update();
-		Sleep(1);
+	    window.Flush();                     // what a run that did not halt left in the FIFO
+	    window.Display(cpu.Ram().IoBase());
 	}
 
     return 0;
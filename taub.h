@@ -0,0 +1,6155 @@
+/***************************************************************************************
+                System Components and Control Operations
+
+    Control Operations                      Explanation
+ -------------------------------------------------------------------------------------
+ 1. GPR -> M                [GPR_M]       // Write contents of GPR into addressed memory location
+ 2. PC + 1 -> PC            [INCPC]       // Increment PC
+ 3. GPR(AD) -> PC           [GPR_PC]      // Transfer address bits in general-purpose register to PC
+ 4. PC > MAR               [PC_MAR]      // Transfer from PC to MAR
+ 5. GPR(AD) -> MAR          [GPR_MAR]     // Transfer address bits in general-purpose register to MAR
+ 6. GPR(OP)-> OPR           [GPR_OPR]     // Transfer operation bits in general-purpose register to OPR
+ 7. M -> GPR                [M_GPR]       // Transfer addressed word to GPR
+ 8. Acc -> GPR              [Acc_GPR]     // Transfer contents of Acc to GPR
+ 9. PC -> GPR(AD)           [PC_GPR]      // Transfer contents of program counter to address part of MAR
+ 10. GPR + 1 -> GPR         [INCGPR]      // Increment GPR
+ 11. GPR + Acc -> Acc       [ADD]         // Add number in GPR to number in Acc and leave sum in Acc
+ 12. 0 -> Acc               [CLRAcc]      // Clear Acc
+ 13. ROR F, Acc             [ROR]         // Rotate Acc to right through F
+ 14. ROL F. Acc             [ROL]         // Rotate Acc to left through F
+ 15. 0 -> F                 [CLRF]        // Reset flip-flop F
+ 16. ~F -> F                [COMF]        // Complement flip-flop F
+ 17. ~Acc > Acc            [COMAcc]      // Complement Acc
+ 18. Acc + 1 > Acc         [INCAcc]      // Increment Acc
+
+ ****************************************************************************************/
+
+#ifndef TAUB_H
+#define TAUB_H
+
+#include <iostream>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <ostream>
+#include <tuple>
+#include <thread>
+#include <mutex>
+#include <deque>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <filesystem>
+#include <atomic>
+#include <condition_variable>
+#include <new>
+#include <iomanip>
+#include <cmath>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>                    // file mapping only; BYTE/WORD/DWORD come from here as well
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+typedef uint8_t BYTE;
+typedef uint16_t WORD;
+typedef uint32_t DWORD;
+#endif
+
+#ifdef _MSC_VER
+#define NOINLINE    __declspec(noinline)
+#else
+#define NOINLINE    __attribute__((noinline))   // kept out of line: cold paths, and the operator new of the executable
+#endif
+
+
+
+// 18 microoperations + 2
+// 0b [INCA] [COMA] [COMF] [CLRF] [ROL] [ROR] [CLRA] [ADD] [INCGPR] [PC_GPR] [A_GPR] [M_GPR] [GPR_OP] [GPR_MAR] [PC_MAR]  [GPR_PC] [INCPC] [GPR_M]
+
+#define GPR_M       0b00000000000000000000000000000001		// -1  definition of control lines (DWORD 32-bit)
+#define INCPC       0b00000000000000000000000000000010      // -2
+#define GPR_PC      0b00000000000000000000000000000100      // -3
+#define PC_MAR      0b00000000000000000000000000001000      // -4
+#define GPR_MAR     0b00000000000000000000000000010000      // -5
+#define GPR_OP      0b00000000000000000000000000100000      // -6
+#define M_GPR       0b00000000000000000000000001000000      // -7
+#define A_GPR       0b00000000000000000000000010000000      // -8
+#define PC_GPR 	    0b00000000000000000000000100000000      // -9
+#define INCGPR      0b00000000000000000000001000000000      // -10
+#define ADD   		0b00000000000000000000010000000000      // -11
+#define CLRA   		0b00000000000000000000100000000000      // -12
+#define ROR   		0b00000000000000000001000000000000      // -13
+#define ROL   		0b00000000000000000010000000000000      // -14
+#define CLRF   		0b00000000000000000100000000000000      // -15
+#define COMF   		0b00000000000000001000000000000000      // -16
+#define COMA   		0b00000000000000010000000000000000      // -17
+#define INCA   		0b00000000000000100000000000000000      // -18
+#define INCPCF     	0b00010000000000000000000000000000      // -19
+#define INCPCZ     	0b00100000000000000000000000000000      // -20
+#define CLRSC      	0b01000000000000000000000000000000      // -21
+#define HLT        	0b10000000000000000000000000000000      // -22
+
+#define R_nW1   	0b00000000000001000000000000000000
+#define R_nW2   	0b00000000000010000000000000000000
+#define R_nW3   	0b00000000000100000000000000000000
+#define R_nW4   	0b00000000001000000000000000000000
+#define R_nW5   	0b00000000010000000000000000000000
+#define R_nW6   	0b00000000100000000000000000000000
+#define R_nW7   	0b00000001000000000000000000000000
+#define R_nW8   	0b00000010000000000000000000000000
+#define R_nW9   	0b00000100000000000000000000000000
+#define R_nW10   	0b00001000000000000000000000000000
+
+#define CLOCK_HZ    1843200             // emulated system clock (1.8432 MHz)
+
+// X(mnemonic, opcode, takes an address) - opcodes are bits 8-11 of an instruction word (see SUMMARY OF INSTRUCTIONS).
+// Single source for the Opcode enum, the assembler's mnemonics and Control's microcode slots; keep in opcode order.
+#define TAUB_OPCODES(X)         \
+    X(HLT,  0b0000, false)      \
+    X(CRA,  0b0001, false)      \
+    X(CTA,  0b0010, false)      \
+    X(ITA,  0b0011, false)      \
+    X(CRF,  0b0100, false)      \
+    X(CTF,  0b0101, false)      \
+    X(SFZ,  0b0110, false)      \
+    X(ROR,  0b0111, false)      \
+    X(ROL,  0b1000, false)      \
+    X(ADD,  0b1001, true)       \
+    X(ADDI, 0b1010, true)       \
+    X(STA,  0b1011, true)       \
+    X(JMP,  0b1100, true)       \
+    X(JMPI, 0b1101, true)       \
+    X(CSR,  0b1110, true)       \
+    X(ISZ,  0b1111, true)
+
+enum Opcode
+{
+#define OPCODE_ENUM(m, op, ad) OPC_##m = op,
+    TAUB_OPCODES(OPCODE_ENUM)
+#undef OPCODE_ENUM
+};
+
+struct OpcodeInfo
+{
+    const char* mnemonic;
+    BYTE opcode;
+    bool address;                       // takes an address operand (bits 0-7)
+    BYTE slot;                          // first execute-cycle word in Control::mMicrocode (HLT: the HLT bit, 128)
+};
+
+constexpr OpcodeInfo OpcodeTable[16] = {
+#define OPCODE_INFO(m, op, ad) { #m, op, ad, (BYTE)((op) ? (op) << 3 : 0b1000'0000) },
+    TAUB_OPCODES(OPCODE_INFO)
+#undef OPCODE_INFO
+};
+
+constexpr bool OpcodeTableInOrder()
+{
+    for (int i = 0; i < 16; i++)
+    {
+        if (OpcodeTable[i].opcode != i) return false;
+    }
+    return true;
+}
+
+static_assert(OpcodeTableInOrder(), "TAUB_OPCODES must list every opcode once, in opcode order");
+
+#define PHASE_RISING    0b0001          // clock phases a component implements (Phases member, used by StaticPipeline)
+#define PHASE_HIGH      0b0010
+#define PHASE_FALLING   0b0100
+#define PHASE_LOW       0b1000
+
+// typedef unsigned char BYTE;        // 8-bits
+// typedef unsigned short int WORD;   // 16-bits
+// typedef unsigned int DWORD;        // 32-bits
+
+class Component							// component interface class of the CPU
+{
+public:
+	virtual void Reset() {}				// virtual defines that this Function will be overwritten in derived classes
+	virtual void RisingEdge() {}        // Control BUS
+	virtual void HighLevel() {}         // for output ( Component -> BUS )
+	virtual void FallingEdge() {}       // increment, complement, swap, clear vb.
+	virtual void LowLevel() {}          // for input   ( BUS -> Component )
+	virtual BYTE Reacts(DWORD)          // phases that do something under this control word (SCHED_EVENT); the rising
+	{                                   // edge makes the control word, so PHASE_RISING must not depend on it
+	    return PHASE_RISING | PHASE_HIGH | PHASE_FALLING | PHASE_LOW;
+	}
+
+};
+
+/*******************************************************************************************************************
+
+                            MACHINE STATE
+    ------------------------------------------------------------------
+     offset     field
+    ------------------------------------------------------------------
+      0         reg[7]      SC, PC, MAR, OPR, GPR, Acc, F (RegIndex order)
+     14         bus         data bus lines
+     16         control     control word of the current clock
+     20         opcode      opcode latched by Control
+     21         halted      set by HLT
+     22         mem[256]    page 0 of the main store (all of it at ADDR_BITS = 8)
+    ------------------------------------------------------------------
+
+    Everything the machine needs to continue from a clock boundary sits in one 64-byte
+    aligned block: the registers, bus and control word share the first cache line with
+    the start of memory, the whole state is nine lines. The components hold references
+    into it rather than their own storage or pointers to each other, so a snapshot or
+    restore is a plain copy of CoreState.
+
+    Geometry
+    ------------------------------------------------------------------
+     addrBits   address    words      data word (4-bit opcode + address)
+    ------------------------------------------------------------------
+      8         0x00ff      256       12 bit, 0x0fff     default
+      9 - 11                512-2048  13-15 bit
+     12         0x0fff     4096       16 bit, 0xffff
+    ------------------------------------------------------------------
+
+    The instruction format fixes the data width: the opcode sits right above the
+    address field, so a wider address means a wider word. PC, MAR and GPR(AD) are
+    masked to the address width, GPR, Acc and the adder to the data width. Memory is
+    paged in PAGE_WORDS units: page 0 is CoreState::mem, higher pages are allocated on
+    their first store and read as zero until then, so a wide machine running a small
+    program only touches the pages it uses. The default geometry is a single page and
+    never leaves CoreState.
+
+*******************************************************************************************************************/
+
+#define ADDR_BITS       8               // default address width
+#define ADDR_BITS_MAX   12              // opcode + address must fit in a WORD
+#define PAGE_BITS       8
+#define PAGE_WORDS      (1 << PAGE_BITS)    // memory page, page 0 is CoreState::mem
+
+struct Geometry
+{
+    BYTE addrBits;
+    WORD addrMask;                      // PC, MAR, GPR(AD)
+    WORD dataMask;                      // GPR, Acc, memory words as seen by the adder
+    WORD dataTop;                       // most significant data bit, rotated through F by ROL/ROR
+    WORD words;                         // size of the address space
+
+    constexpr Geometry(BYTE bits = ADDR_BITS)
+    : addrBits((bits < ADDR_BITS) ? ADDR_BITS : (bits > ADDR_BITS_MAX) ? ADDR_BITS_MAX : bits),
+      addrMask((WORD)((1u << addrBits) - 1)),
+      dataMask((WORD)((1u << (addrBits + 4)) - 1)),
+      dataTop((WORD)(1u << (addrBits + 3))),
+      words((WORD)(1u << addrBits))
+    {
+    }
+};
+
+enum RegIndex { REG_SC = 0, REG_PC, REG_MAR, REG_OPR, REG_GPR, REG_ACC, REG_F, REG_COUNT };
+
+static const char* const RegNames[REG_COUNT] = { "SC", "PC", "MAR", "OPR", "GPR", "Acc", "F" };
+
+struct alignas(64) CoreState
+{
+    WORD reg[REG_COUNT];
+    WORD bus;
+    DWORD control;
+    BYTE opcode;
+    BYTE halted;
+    WORD mem[PAGE_WORDS];
+};
+
+
+class Register : public Component
+{
+private:
+
+    WORD& mStore;				// CoreState::reg[] word of this register
+    WORD& mDataBus;
+    DWORD& mControlBus;
+    DWORD mInMask, mOutMask, mIncrMask;
+    WORD mBitMask;
+
+public:
+
+    static constexpr BYTE Phases = PHASE_HIGH | PHASE_FALLING | PHASE_LOW;
+
+    Register(CoreState& s, RegIndex reg, DWORD inmask, DWORD outmask, DWORD incrmask, WORD bitmask)
+    : mStore(s.reg[reg]), mDataBus(s.bus), mControlBus(s.control), mInMask(inmask), mOutMask(outmask), mIncrMask(incrmask), mBitMask(bitmask) {}  // bitmask - ka bit register ise set eder.
+
+
+    void HighLevel()        // for output [Component, Memory -> BUS]
+    {
+
+		if (mControlBus & mOutMask)
+		{
+            mDataBus = mStore;
+		}
+
+    }
+
+    void FallingEdge()      // // increment, complement, swap, clear vb.
+    {
+        if ((mControlBus & mIncrMask) || mIncrMask == 0xffff)
+        {
+            Increment();
+        }
+    }
+
+	void LowLevel()      // for input [BUS -> Component, Memory]
+	{
+		if (mControlBus & mInMask)
+		{
+            mStore = mDataBus & mBitMask;
+		}
+
+	}
+
+    BYTE Reacts(DWORD control)
+    {
+        return ((control & mOutMask) ? PHASE_HIGH : 0) | (((control & mIncrMask) || mIncrMask == 0xffff) ? PHASE_FALLING : 0)
+             | ((control & mInMask) ? PHASE_LOW : 0);
+    }
+
+    void Reset()
+    {
+        mStore = 0;
+    }
+
+    void Set(WORD& data)
+    {
+        mStore = data & mBitMask;
+    }
+
+    WORD Get()
+    {
+        return mStore;
+    }
+
+    void Increment()
+    {
+        mStore = (mStore + 1) & mBitMask;
+    }
+
+ };
+
+ inline BYTE LineIndex(DWORD line)     // bit number of a single control line (de Bruijn multiply, no branches)
+{
+    static const BYTE table[32] = { 0, 1, 28, 2, 29, 14, 24, 3, 30, 22, 20, 15, 25, 17, 4, 8,
+                                    31, 27, 13, 23, 21, 19, 16, 7, 26, 12, 18, 6, 11, 5, 10, 9 };
+    return table[(DWORD)(line * 0x077CB531u) >> 27];
+}
+
+// Adder and GprBus act only when exactly one of their input lines is set.
+// Their operations sit in a 32-entry handler table indexed by LineIndex(), so a clock
+// costs one indexed call instead of a chain of compares; lines outside the input mask
+// map to Nop().
+
+ class GprBus: public Component
+{
+private:
+
+    typedef void (GprBus::*Op)();
+
+    WORD& mDataBus;
+    DWORD& mControlBus;
+    DWORD mInMask, mOutMask;
+    WORD& mPC;
+    WORD& mOPR;
+    WORD& mGPR;
+    BYTE mAddrBits;
+    WORD mAddrMask;
+    Op mOps[32];
+
+    void Nop()
+    {
+    }
+
+    void SwapPc()           // PC_GPR: PC <-> GPR(AD)
+    {
+        WORD a, b;
+        a = mPC & mAddrMask;
+        b = mGPR & mAddrMask;
+        mPC = b;
+        mGPR = a;
+    }
+
+    void GprToOpr()         // GPR_OP
+    {
+        WORD a;
+        a = mGPR >> mAddrBits;
+        mOPR = a;
+    }
+
+public:
+
+    static constexpr BYTE Phases = PHASE_FALLING;
+
+    GprBus(CoreState& s, const Geometry& g, DWORD inmask, DWORD outmask)
+	: mDataBus(s.bus), mControlBus(s.control), mInMask(inmask), mOutMask(outmask), mPC(s.reg[REG_PC]), mOPR(s.reg[REG_OPR]), mGPR(s.reg[REG_GPR]),
+	  mAddrBits(g.addrBits), mAddrMask(g.addrMask)
+    {
+        for (Op& op : mOps) op = &GprBus::Nop;
+        if (mInMask & PC_GPR) mOps[LineIndex(PC_GPR)] = &GprBus::SwapPc;
+        if (mInMask & GPR_OP) mOps[LineIndex(GPR_OP)] = &GprBus::GprToOpr;
+    }
+
+
+    void HighLevel()        // for output [Component -> BUS]
+    {
+
+    }
+
+    void FallingEdge()
+    {
+        DWORD lines = mControlBus & mInMask;
+
+        if (lines && !(lines & (lines - 1)))
+		{
+            (this->*mOps[LineIndex(lines)])();
+		}
+    }
+
+    void LowLevel()      // for input [BUS -> Component]
+	{
+
+
+	}
+
+    BYTE Reacts(DWORD control)
+    {
+        return (control & mInMask) ? PHASE_FALLING : 0;
+    }
+
+};
+
+class Adder : public Component
+{
+private:
+
+    typedef void (Adder::*Op)();
+
+    WORD mNextFlag, mFlagZ, mFlagF;
+    WORD mTemp;
+    WORD mStore;
+    WORD& mDataBus;
+    DWORD& mControlBus;
+    DWORD mInMask, mOutMask;
+    WORD& mRegAcc;
+    WORD& mRegGpr;
+    WORD& mRegF;
+    WORD mDataMask, mDataTop;
+    Op mOps[32];
+
+    void Nop()
+    {
+    }
+
+    void AccToGpr()         // A_GPR
+    {
+        WORD a = (mRegAcc & mDataMask);
+        mRegGpr = a;
+    }
+
+    void AddGpr()           // ADD
+    {
+        mRegAcc = mStore;
+    }
+
+    void ComAcc()           // COMA
+    {
+        WORD a = (~(mRegAcc) & mDataMask);  // a = ((mRegAcc ^ 0xffff) & mDataMask);
+        mRegAcc = a;
+    }
+
+    void ComF()             // COMF
+    {
+        WORD a = (((mRegF) ^ 0x0001) & 0x0003);
+        mRegF = a;
+    }
+
+    void ClrAcc()           // CLRA
+    {
+        mRegAcc = 0;
+    }
+
+    void ClrF()             // CLRF
+    {
+        WORD a = ((mRegF) & 0x0002);
+        mRegF = a;
+    }
+
+    void SetOp(DWORD line, Op op)
+    {
+        if (mInMask & line) mOps[LineIndex(line)] = op;
+    }
+
+public:
+
+    static constexpr BYTE Phases = PHASE_HIGH | PHASE_FALLING;
+
+	Adder(CoreState& s, const Geometry& g, DWORD inmask, DWORD outmask)
+	: mDataBus(s.bus), mControlBus(s.control), mInMask(inmask), mOutMask(outmask), mRegAcc(s.reg[REG_ACC]), mRegGpr(s.reg[REG_GPR]), mRegF(s.reg[REG_F]),
+	  mDataMask(g.dataMask), mDataTop(g.dataTop)
+    {
+        for (Op& op : mOps) op = &Adder::Nop;
+        SetOp(A_GPR, &Adder::AccToGpr);
+        SetOp(ADD, &Adder::AddGpr);
+        SetOp(COMA, &Adder::ComAcc);
+        SetOp(COMF, &Adder::ComF);
+        SetOp(CLRA, &Adder::ClrAcc);
+        SetOp(CLRF, &Adder::ClrF);
+        SetOp(ROL, &Adder::RolAcc);
+        SetOp(ROR, &Adder::RorAcc);
+    }
+
+	void HighLevel()       // for output
+    {
+
+		mStore = (mRegAcc + mRegGpr) & mDataMask ;
+
+		if (mControlBus & mOutMask)
+		{
+			// mDataBus = mRegAcc;
+		}
+    }
+
+    void FallingEdge()
+    {
+        mNextFlag = mRegF;
+        (mNextFlag & 0x0001) ?  mFlagF = 1 : mFlagF = 0;        // Save Current Flag;
+
+		if (mRegGpr)           // 0b0000'00ZF
+        {
+            mNextFlag = mNextFlag & 0x0001; // set Z = 0 bit 1 in Flag Reg. 0b0000'000F
+            mRegF = mNextFlag;
+        }
+		else
+        {
+            mNextFlag = mNextFlag | 0x0002;   // set Z = 0 bit 1 in Flag Reg. 0b0000'001F
+            mRegF = mNextFlag;         // if GPR = 0 => Z = 1
+        }
+
+        DWORD lines = mControlBus & mInMask;
+
+        if (lines && !(lines & (lines - 1)))     // exactly one line
+		{
+            (this->*mOps[LineIndex(lines)])();
+		}
+
+    }
+
+    BYTE Reacts(DWORD control)          // Z follows GPR on every falling edge; the sum is only read by ADD
+    {
+        return ((control & ADD) ? PHASE_HIGH : 0) | PHASE_FALLING;
+    }
+
+    void RolAcc()
+    {
+        mStore = mRegAcc;
+        if (mStore & mDataTop)
+        {
+            mNextFlag |= 0x0001;
+            mRegF = mNextFlag;
+        }
+        else
+        {
+            mNextFlag &= 0x0002;
+            mRegF = mNextFlag;  // if msb =1 F flag is 1 else 0.
+        }
+        mStore = ((mStore << 1) & mDataMask) | mFlagF;
+        mRegAcc = mStore;
+    }
+
+    void RorAcc()
+    {
+        WORD acc;
+        acc = mRegAcc;
+        if (acc & 0x0001)
+        {
+            mNextFlag |= 0x0001;
+            mRegF = mNextFlag;
+        }
+        else
+        {
+            mNextFlag &= 0x0002;
+            mRegF = mNextFlag;  // if lsb =1 F flag is 1 else 0.
+        }
+        acc = ((acc >> 1) & mDataMask);
+        mFlagF ? (acc |= mDataTop) : (acc |= 0x0000);
+        mRegAcc = acc;
+    }
+
+};
+
+/*
+            SUMMARY OF INSTRUCTIONS                                    [Opcode]
+    ----------------------------------------------------------------------------
+     1. CRA clear accumulator   ........................................[0001]
+     2. CTA complement accumulator  ....................................[0010]
+     3. ITA increment accumulator   ....................................[0011]
+     4. CRF clear flip-flop F   ........................................[0100]
+     5. CTF complement flip-flop F  ....................................[0101]
+     6. SFZ skip next instruction if F = 0  ............................[0110]
+     7. ROR rotate right    ............................................[0111]
+     8. ROL rotate left     ............................................[1000]
+     9. ADD add to accumulator  ........................................[1001]
+     10. ADDI add indirect to accumulator   ............................[1010]
+     11. STA store in memory from accumulator   ........................[1011]
+     12. JMP jump       .........,,,,,,,,...............................[1100]
+     13. JMPI jump indirect     ........................................[1101]
+     14. CSR call subroutine    ........................................[1110]
+     15. ISZ increment and skip if Z = 0    ............................[1111]
+     16. HLT Halt       ................................................[0000]
+    -----------------------------------------------------------------------------
+
+*/
+
+const WORD DefaultProgram[] = {        // program loaded when no image file is given
+    0b0000'0001'0000'0000, // 00 CRA x x        CRA
+    0b0000'1001'0001'0011, // 01 ADD 1 3        ADD NUMA
+    0b0000'1011'0001'0110, // 02 STA 1 6        STA NUM
+    0b0000'1110'0001'1000, // 03 CSR 1 8        CSR DBL
+    0b0000'1001'0001'0111, // 04 ADD 1 7        ADD SUM
+    0b0000'1011'0001'0111, // 05 STA 1 7        STA SUM
+    0b0000'0001'0000'0000, // 06 CRA x x        CRA
+    0b0000'1001'0001'0100, // 07 ADD 1 4        ADD NUMB
+    0b0000'1011'0001'0110, // 08 STA 1 6        STA NUM
+    0b0000'1110'0001'1000, // 09 CSR 1 8        CSR DBL
+    0b0000'1001'0001'0111, // 10 ADD 1 7        ADD SUM
+    0b0000'1011'0001'0111, // 11 STA 1 7        STA SUM
+    0b0000'0001'0000'0000, // 12 CRA x x        CRA
+    0b0000'1001'0001'0101, // 13 ADD 1 5        ADD NUMC
+    0b0000'1011'0001'0110, // 14 STA 1 6        STA NUM
+    0b0000'1110'0001'1000, // 15 CSR 1 8        CSR DBL
+    0b0000'1001'0001'0111, // 16 ADD 1 7        ADD SUM
+    0b0000'1011'0001'0111, // 17 STA 1 7        STA SUM
+    0b0000'0000'0000'0000, // 18 HLT x x        HLT
+    0b0000'0000'0000'0011, // 19 0 0 3  [NUMA]  [3]
+    0b0000'0000'0001'0001, // 20 0 1 1  [NUMB]  [17]
+    0b0000'0000'0010'0000, // 21 0 2 0  [NUMC]  [32]
+    0b0000'0000'0000'0000, // 22 0 0 0  [NUM]
+    0b0000'0000'0000'0000, // 23 0 0 0  [SUM]   [104] <- Result
+    0b0000'0000'0000'0000, // 24 x x x     [SUB DBL]
+    0b0000'0001'0000'0000, // 25 CRA  x x       CRA
+    0b0000'1001'0001'0110, // 26 ADD  1 6       ADD NUM
+    0b0000'1000'0000'0000, // 27 ROL  x x       ROL
+    0b0000'1101'0001'1000, // 28 JMPI 1 8       JMPI [SUB DBL]
+    0b0000'0000'0000'0000, // 29
+    0b0000'0000'0000'0000 };
+
+const WORD ProgAddList[] = { // Prog - 3, sum of a list through ADDI: 1+3+5+7+9+11 -> RES (36)
+    0b0000'0001'0000'0000, // 00 CRA  x x           CRA
+    0b0000'1010'0000'1000, // 01 ADDI 0 8     LOOP  ADDI ANA
+    0b0000'1111'0000'1000, // 02 ISZ  0 8           ISZ ANA
+    0b0000'1111'0000'1001, // 03 ISZ  0 9           ISZ CTR
+    0b0000'1100'0000'0001, // 04 JMP  0 1           JMP LOOP
+    0b0000'1011'0000'0111, // 05 STA  0 7           STA RES
+    0b0000'0000'0000'0000, // 06 HLT  x x           HLT
+    0b0000'0000'0000'0000, // 07 0 0 0  [RES]  <- Store result
+    0b0000'0000'0000'1010, // 08 0 0 A  [ANA]
+    0b0000'1111'1111'1010, // 09 F F A  [CTR] (-6)
+    0b0000'0000'0000'0001, // 10 0 0 1  [00A] (Adding numbers) <- first number
+    0b0000'0000'0000'0011, // 11 0 0 3
+    0b0000'0000'0000'0101, // 12 0 0 5
+    0b0000'0000'0000'0111, // 13 0 0 7
+    0b0000'0000'0000'1001, // 14 0 0 9
+    0b0000'0000'0000'1011, // 15 0 0 B  <- Last number
+    0b0000'0000'0000'0000 };
+
+const WORD ProgRolLoop[] = { // Prog - 7, ROL loop: rotate left until the ISZ counter wraps
+    0b0000'0001'0000'0000, // 00 CRA x x        CRA
+    0b0000'0101'0000'0000, // 01 CTF x x        CTF
+    0b0000'1000'0000'0000, // 02 ROL x x   lOOP ROL
+    0b0000'1111'0000'0111, // 03 ISZ 0 7        ISZ CTR
+    0b0000'0110'0000'0000, // 04 SFZ x x        SFZ
+    0b0000'0000'0000'0000, // 05 HLT x x        HLT
+    0b0000'1100'0000'0010, // 06 JMP 0 2        JMP LOOP
+    0b0000'0000'0000'0000, // 07 0 0 0  [CTR]
+    0b0000'0000'0000'0000, // 08
+    0b0000'0000'0000'0000 };
+
+const WORD ProgRorLoop[] = { // Prog - 6, ROR loop: rotate right until the ISZ counter wraps
+    0b0000'0001'0000'0000, // 00 CRA x x        CRA
+    0b0000'0101'0000'0000, // 01 CTF x x        CTF
+    0b0000'0111'0000'0000, // 02 ROR x x   lOOP ROR
+    0b0000'1111'0000'0111, // 03 ISZ 0 7        ISZ CTR
+    0b0000'0110'0000'0000, // 04 SFZ x x        SFZ
+    0b0000'0000'0000'0000, // 05 HLT x x        HLT
+    0b0000'1100'0000'0010, // 06 JMP 0 2        JMP LOOP
+    0b0000'0000'0000'0000, // 07 0 0 0  [CTR]
+    0b0000'0000'0000'0000, // 08
+    0b0000'0000'0000'0000 };
+
+
+const WORD ProgSubtract[] = { // Prog - 5, subtraction: MIN - SUB2 - SUB1 -> DIF
+    0b0000'0001'0000'0000, // 00 CRA x x    CRA
+    0b0000'1001'0000'1101, // 01 ADD 0 7    ADD SUB1
+    0b0000'0010'0000'0000, // 02 CTA x x    CTA
+    0b0000'0011'0000'0000, // 03 ITA x x    ITA
+    0b0000'1011'0000'1101, // 04 STA 0 9    STA SUB1
+    0b0000'0001'0000'0000, // 05 CRA x x    CRA
+    0b0000'1001'0000'1110, // 06 ADD 0 7    ADD SUB2
+    0b0000'0010'0000'0000, // 07 CTA x x    CTA
+    0b0000'0011'0000'0000, // 08 ITA x x    ITA
+    0b0000'1001'0000'1101, // 09 ADD 0 7    ADD SUB1
+    0b0000'1001'0000'1111, // 10 ADD 0 8    ADD MIN
+    0b0000'1011'0001'0000, // 11 STA 0 9    STA DIF
+    0b0000'0000'0000'0000, // 12 HLT x x    HLT
+    0b0000'0000'0000'0101, // 13 0 0 0  [SUB1]
+    0b0000'0000'1001'1100, // 14 0 9 C  [SUB2]
+    0b0000'0000'1011'0111, // 15 0 B 7  [MIN]
+    0b0000'0000'0000'0000, // 16 x x x  [DIF]
+    0b0000'0000'0000'0000, // 17
+    0b0000'0000'0000'0000 };
+
+const WORD ProgMultiply[] = { // Prog - 4, multiplication by shift and add: MD * MR -> SP
+    0b0000'0001'0000'0000, // 00 CRA  x x           CRA
+    0b0000'1011'0001'1000, // 01 STA  1 8           STA SP
+    0b0000'0001'0000'0000, // 02 CRA  x x     LOOP  CRA
+    0b0000'1001'0001'0111, // 03 ADD  1 7           ADD MR
+    0b0000'0111'0000'0000, // 04 ROR  x x           ROR
+    0b0000'1011'0001'0111, // 05 STA  1 7           STA MR
+    0b0000'0110'0000'0000, // 06 SFZ  x x           SFZ
+    0b0000'1100'0000'1001, // 07 JMP  0 9           JMP 1
+    0b0000'1100'0000'1110, // 08 JMP  0 E           JMP 0
+    0b0000'0001'0000'0000, // 09 CRA  x x         1 CRA
+    0b0000'1001'0001'0110, // 10 ADD  1 6           ADD MD
+    0b0000'1001'0001'1000, // 11 ADD  1 8           ADD SP
+    0b0000'1011'0001'1000, // 12 STA  1 8           STA SP
+    0b0000'0100'0000'0000, // 13 CRF  x x           CRF
+    0b0000'0001'0000'0000, // 14 CRA  x x         0 CRA
+    0b0000'1001'0001'0110, // 15 ADD  1 6           ADD MD
+    0b0000'1000'0000'0000, // 16 ROL  x x           ROL
+    0b0000'1011'0001'0110, // 17 STA  1 6           STA MD
+    0b0000'1111'0001'0101, // 18 ISZ  1 5           1SZ CTR
+    0b0000'1100'0000'0010, // 19 JMP  0 2           JMP LOOP
+    0b0000'0000'0000'0000, // 20 HLT  x x           HLT
+    0b1111'1111'1111'0100, // 21 F F 4  [CTR] (-12)
+    0b0000'0000'0110'0100, // 22 0 6 4  [MD]    // Multiplicand (100)
+    0b0000'0000'0000'0010, // 23 0 0 2  [MR]    // Multiplier   (3)
+    0b0000'0000'0000'0000, // 24 0 0 0  [SP]    // Result       (300) (12C)H
+    0b0000'0000'0000'0000, // 25 0 0 0
+    0b0000'0000'0000'0000, // 26 0 0 0
+    0b0000'0000'0000'0000 };
+
+struct ReferenceProgram
+{
+    const char* name;
+    const WORD* image;
+    WORD size;
+};
+
+#define REF_PROGRAM(name, words)    { name, words, sizeof(words)/sizeof(WORD) }
+
+const ReferenceProgram ReferencePrograms[] =    // run by --bench on every engine
+{
+    REF_PROGRAM("dbl-sum",  DefaultProgram),
+    REF_PROGRAM("multiply", ProgMultiply),
+    REF_PROGRAM("subtract", ProgSubtract),
+    REF_PROGRAM("ror-loop", ProgRorLoop),
+    REF_PROGRAM("rol-loop", ProgRolLoop),
+    REF_PROGRAM("add-list", ProgAddList),
+};
+
+inline const ReferenceProgram* FindProgram(const char* name)    // nullptr if no ReferencePrograms[] entry has that name
+{
+    for (const ReferenceProgram& p : ReferencePrograms)
+    {
+        if (strcmp(p.name, name) == 0) return &p;
+    }
+    return nullptr;
+}
+
+
+/* Prog - 2
+WORD prg[] = {
+    0b0000'0001'0000'0000, // 00 CRA x x    CRA
+    0b0000'1001'0000'0111, // 01 ADD 0 7    ADD SUB
+    0b0000'0010'0000'0000, // 02 CTA x x    CTA
+    0b0000'0011'0000'0000, // 03 ITA x x    ITA
+    0b0000'1001'0000'1000, // 04 ADD 0 8    ADD MIN
+    0b0000'1011'0000'1001, // 05 STA 0 9    STA DIF
+    0b0000'0000'0000'0000, // 06 HLT x x    HLT
+    0b0000'0000'1001'1100, // 07 0 9 C  [SUB]
+    0b0000'0000'1011'0111, // 08 0 B 7  [MIN]
+    0b0000'0000'0000'0000, // 09 x x x  [DIF]
+    0b0000'0000'0000'0000, // 10
+    0b0000'0000'0000'0000, // 11
+    0b0000'0000'0000'0000, // 12
+    0b0000'0000'0000'0000, // 13
+    0b0000'0000'0000'0000, // 14
+    0b0000'0000'0000'0000, // 15
+    0b0000'0000'0000'0000 };
+
+*/
+
+/*  Prog - 1
+WORD prg[] = {
+    0b0000'0001'0000'0000, // 00 CRA x x
+    0b0000'1001'0000'0110, // 01 ADD 0 6
+    0b0000'1001'0000'0111, // 02 ADD 0 7
+    0b0000'1001'0000'1000, // 03 ADD 0 8
+    0b0000'1011'0000'1001, // 04 STA 0 9
+    0b0000'0000'0000'0000, // 05 HLT x x
+    0b0000'0000'0001'0111, // 06 0 1 7
+    0b0000'0000'0000'1011, // 07 0 0 B
+    0b0000'0000'0001'1100, // 08 0 1 C
+    0b0000'0000'0000'0000, // 09 x x x
+    0b0000'0000'0000'0000, // 10
+    0b0000'0000'0000'0000, // 11
+    0b0000'0000'0000'0000, // 12
+    0b0000'0000'0000'0000, // 13
+    0b0000'0000'0000'0000, // 14
+    0b0000'0000'0000'0000, // 15
+    0b0000'0000'0000'0000 };
+
+*/
+
+
+/*******************************************************************************************************************
+
+                            PROGRAM IMAGES
+    ------------------------------------------------------------------
+     <name>.img     raw memory image: one little-endian 16-bit word per address,
+                    starting at address 0 (12-bit data in the low bits, like prg[])
+     <name>.img.sym optional symbol table, one "NAME ADDRESS" pair per line,
+                    '#' starts a comment (e.g. "SUM 23"); a "#bits N" line records
+                    the address width the image was built for
+    ------------------------------------------------------------------
+
+    An instruction word is opcode << addrBits | address, so an image only runs on the
+    Geometry it was assembled for. The Assembler writes "#bits N" and
+    Computer::LoadProgram(ProgramImage&) refuses an image whose width differs from
+    the machine's. An image without that line (no .sym, or an older one) is loaded as
+    it is, and its width must match. The built-in programs (DefaultProgram,
+    ReferencePrograms[]) are 8-bit.
+
+    The image file is memory-mapped. Memory::Load() decodes the words straight from
+    the mapping into the image it keeps for Reload(), then copies that into the
+    store. A runner can therefore stream many images through one warm Computer
+    without recompiling and without allocating per load.
+
+*******************************************************************************************************************/
+
+struct Symbol
+{
+    std::string name;
+    WORD addr;
+};
+
+class ProgramImage
+{
+private:
+
+    const BYTE* mData;
+    size_t mSize;                       // bytes
+    std::vector<Symbol> mSymbols;
+    BYTE mBits;                         // "#bits N" of the .sym file, 0 = not recorded
+#ifdef _WIN32
+    HANDLE mFile, mMapping;
+#endif
+
+    void LoadSymbols(const std::string& path)
+    {
+        std::ifstream in(path);
+        std::string line;
+
+        while (std::getline(in, line))
+        {
+            if (line.compare(0, 6, "#bits ") == 0)
+            {
+                mBits = (BYTE)atoi(line.c_str() + 6);
+                continue;
+            }
+            std::istringstream ls(line.substr(0, line.find('#')));
+            Symbol s;
+            std::string addr;
+            if (ls >> s.name >> addr)
+            {
+                s.addr = (WORD)strtoul(addr.c_str(), nullptr, 0);
+                mSymbols.push_back(s);
+            }
+        }
+    }
+
+public:
+
+    ProgramImage()
+    : mData(nullptr), mSize(0), mBits(0)
+    {
+#ifdef _WIN32
+        mFile = mMapping = nullptr;
+#endif
+    }
+
+    ~ProgramImage()
+    {
+        Close();
+    }
+
+    ProgramImage(const ProgramImage&) = delete;
+    ProgramImage& operator=(const ProgramImage&) = delete;
+
+    bool Open(const char* path)         // maps path and reads path.sym if it exists
+    {
+        Close();
+#ifdef _WIN32
+        mFile = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (mFile == INVALID_HANDLE_VALUE)
+        {
+            mFile = nullptr;
+            return false;
+        }
+        mSize = GetFileSize(mFile, nullptr);
+        if (mSize)
+        {
+            mMapping = CreateFileMappingA(mFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            mData = mMapping ? (const BYTE*)MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+            if (!mData)
+            {
+                Close();
+                return false;
+            }
+        }
+#else
+        int fd = open(path, O_RDONLY);
+        struct stat st;
+        if (fd < 0)
+        {
+            return false;
+        }
+        if (fstat(fd, &st) != 0)
+        {
+            close(fd);
+            return false;
+        }
+        mSize = (size_t)st.st_size;
+        if (mSize)
+        {
+            void* p = mmap(nullptr, mSize, PROT_READ, MAP_PRIVATE, fd, 0);
+            mData = (p == MAP_FAILED) ? nullptr : (const BYTE*)p;
+        }
+        close(fd);
+        if (mSize && !mData)
+        {
+            mSize = 0;
+            return false;
+        }
+#endif
+        LoadSymbols(std::string(path) + ".sym");
+        return true;
+    }
+
+    void Close()
+    {
+#ifdef _WIN32
+        if (mData) UnmapViewOfFile(mData);
+        if (mMapping) CloseHandle(mMapping);
+        if (mFile) CloseHandle(mFile);
+        mFile = mMapping = nullptr;
+#else
+        if (mData) munmap((void*)mData, mSize);
+#endif
+        mData = nullptr;
+        mSize = 0;
+        mSymbols.clear();
+        mBits = 0;
+    }
+
+    size_t Words()
+    {
+        return mSize / 2;
+    }
+
+    WORD Word(size_t i)                 // little-endian
+    {
+        return (WORD)(mData[2 * i] | (mData[2 * i + 1] << 8));
+    }
+
+    const std::vector<Symbol>& Symbols()
+    {
+        return mSymbols;
+    }
+
+    BYTE Bits()                         // address width the image was built for, 0 = unknown
+    {
+        return mBits;
+    }
+
+    static bool Save(const char* path, const WORD* image, size_t n)    // writes the raw .img format
+    {
+        std::ofstream out(path, std::ios::binary);
+        for (size_t i = 0; i < n && out; i++)
+        {
+            char b[2] = { (char)(image[i] & 0xff), (char)(image[i] >> 8) };
+            out.write(b, 2);
+        }
+        return (bool)out;
+    }
+};
+
+
+/*******************************************************************************************************************
+
+                            ASSEMBLER
+    ------------------------------------------------------------------
+     [LABEL:]  MNEMONIC [ADDRESS]       ; instruction, ADDRESS is a label or a number
+     [LABEL:]  VALUE                    ; data word (decimal, 0x.., 0b.., negative = two's complement)
+               ORG ADDRESS              ; continue assembling at ADDRESS
+               BITS N                   ; address width 8-12 of the target Geometry (default 8)
+     ; or //   comment to end of line
+    ------------------------------------------------------------------
+
+        CRA                             ; the DBL-sum program of DefaultProgram[]
+        ADD NUMA
+        STA NUM
+        CSR DBL
+        ...
+        HLT
+    NUMA: 3
+        ...
+    DBL:  0                             ; return address, written by CSR
+        CRA
+        ADD NUM
+        ROL
+        JMPI DBL
+
+    Mnemonics come from OpcodeTable. Output is the .img/.img.sym pair read by
+    ProgramImage. AssembleCached() keys the output by a hash of the source text, so
+    assembling an unchanged file again only opens the cached image.
+
+*******************************************************************************************************************/
+
+#define ASM_VERSION   2                 // part of the cache key; bump when the output format changes
+
+class Assembler
+{
+private:
+
+    std::vector<WORD> mImage;
+    std::vector<Symbol> mSymbols;
+    std::string mError;
+    int mBits = ADDR_BITS;              // the last BITS, written to the .sym file
+
+    static std::string Upper(std::string s)
+    {
+        for (auto& c : s) c = (char)toupper((unsigned char)c);
+        return s;
+    }
+
+    static bool Number(const std::string& s, long& v)
+    {
+        const char* p = s.c_str();
+        char* end;
+        if (s.size() > 2 && s[0] == '0' && (s[1] == 'b' || s[1] == 'B'))
+        {
+            v = strtol(p + 2, &end, 2);
+        }
+        else
+        {
+            v = strtol(p, &end, 0);
+        }
+        return !s.empty() && *end == 0;
+    }
+
+    bool Fail(int line, const std::string& msg)
+    {
+        mError = "line " + std::to_string(line) + ": " + msg;
+        return false;
+    }
+
+    int Find(const std::string& name)
+    {
+        for (size_t i = 0; i < mSymbols.size(); i++)
+        {
+            if (mSymbols[i].name == name) return (int)i;
+        }
+        return -1;
+    }
+
+    bool Pass(const std::string& source, bool emit)     // pass 1 collects labels, pass 2 emits words
+    {
+        std::istringstream in(source);
+        std::string text;
+        int line = 0;
+        long loc = 0, v;
+        int bits = ADDR_BITS;           // BITS: opcode position and address range
+        long top = (1L << bits) - 1;
+
+        while (std::getline(in, text))
+        {
+            line++;
+            size_t c = std::min(text.find(';'), text.find("//"));
+            std::istringstream ls(text.substr(0, c));
+            std::vector<std::string> tok;
+            std::string t;
+            while (ls >> t) tok.push_back(t);
+
+            size_t k = 0;
+            if (k < tok.size() && tok[k].back() == ':')
+            {
+                std::string name = tok[k].substr(0, tok[k].size() - 1);
+                if (!emit)
+                {
+                    if (name.empty() || Find(name) >= 0) return Fail(line, "bad or duplicate label '" + name + "'");
+                    mSymbols.push_back({ name, (WORD)loc });
+                }
+                k++;
+            }
+            if (k == tok.size()) continue;
+
+            std::string op = Upper(tok[k]);
+            const OpcodeInfo* info = nullptr;
+            for (const OpcodeInfo& o : OpcodeTable)
+            {
+                if (op == o.mnemonic) info = &o;
+            }
+
+            if (op == "ORG")
+            {
+                if (k + 2 != tok.size() || !Number(tok[k + 1], v) || v < 0 || v > top) return Fail(line, "ORG needs an address 0-" + std::to_string(top));
+                loc = v;
+                continue;
+            }
+            if (op == "BITS")
+            {
+                if (k + 2 != tok.size() || !Number(tok[k + 1], v) || v < ADDR_BITS || v > ADDR_BITS_MAX) return Fail(line, "BITS needs 8-12");
+                bits = (int)v;
+                top = (1L << bits) - 1;
+                continue;
+            }
+
+            WORD word;
+            if (info)
+            {
+                long ad = 0;
+                if (info->address)
+                {
+                    if (k + 2 != tok.size()) return Fail(line, op + " needs one address");
+                    int s = Find(tok[k + 1]);
+                    if (s >= 0) ad = mSymbols[s].addr;
+                    else if (Number(tok[k + 1], ad)) { if (ad < 0 || ad > top) return Fail(line, "address out of range"); }
+                    else if (emit) return Fail(line, "unknown label '" + tok[k + 1] + "'");
+                }
+                else if (k + 1 != tok.size())
+                {
+                    return Fail(line, op + " takes no operand");
+                }
+                word = (WORD)((info->opcode << bits) | (ad & top));
+            }
+            else if (k + 1 == tok.size() && Number(tok[k], v) && v >= -32768 && v <= 65535)
+            {
+                word = (WORD)v;              // data word
+            }
+            else
+            {
+                return Fail(line, "unknown mnemonic '" + tok[k] + "'");
+            }
+
+            if (loc > top) return Fail(line, "program does not fit in " + std::to_string(top + 1) + " words");
+            if (emit)
+            {
+                if ((size_t)loc >= mImage.size()) mImage.resize(loc + 1, 0);
+                mImage[loc] = word;
+            }
+            loc++;
+        }
+        mBits = bits;
+        return true;
+    }
+
+public:
+
+    bool Assemble(const std::string& source)
+    {
+        mImage.clear();
+        mSymbols.clear();
+        mError.clear();
+        return Pass(source, false) && Pass(source, true);
+    }
+
+    const std::vector<WORD>& Image()
+    {
+        return mImage;
+    }
+
+    const std::vector<Symbol>& Symbols()
+    {
+        return mSymbols;
+    }
+
+    const std::string& Error()
+    {
+        return mError;
+    }
+
+    bool Write(const std::string& path)             // path and path.sym
+    {
+        if (!ProgramImage::Save(path.c_str(), mImage.data(), mImage.size())) return false;
+        std::ofstream sym(path + ".sym");
+        sym << "#bits " << mBits << "\n";
+        for (const Symbol& s : mSymbols)
+        {
+            sym << s.name << " " << s.addr << "\n";
+        }
+        return (bool)sym;
+    }
+
+    static uint64_t Hash(const std::string& s)      // FNV-1a, seeded with ASM_VERSION
+    {
+        uint64_t h = 14695981039346656037ull ^ ASM_VERSION;
+        for (unsigned char c : s)
+        {
+            h = (h ^ c) * 1099511628211ull;
+        }
+        return h;
+    }
+
+    // Assembles srcPath into cacheDir/<hash>.img unless that file already exists; imgPath receives the image path.
+    bool AssembleCached(const char* srcPath, const std::string& cacheDir, std::string& imgPath, bool& cached)
+    {
+        std::ifstream in(srcPath, std::ios::binary);
+        if (!in)
+        {
+            mError = std::string("cannot open ") + srcPath;
+            return false;
+        }
+        std::string source((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+        char key[17];
+        snprintf(key, sizeof(key), "%016llx", (unsigned long long)Hash(source));
+        imgPath = cacheDir + "/" + key + ".img";
+
+        cached = std::ifstream(imgPath).good();
+        if (cached)
+        {
+            return true;
+        }
+        if (!Assemble(source))
+        {
+            return false;
+        }
+        std::error_code ec;
+        std::filesystem::create_directories(cacheDir, ec);
+        std::string tmp = imgPath + ".tmp";             // renamed into place so readers never see half a file
+        if (!Write(tmp))
+        {
+            mError = "cannot write " + imgPath;
+            return false;
+        }
+        std::filesystem::rename(tmp + ".sym", imgPath + ".sym", ec);
+        std::filesystem::rename(tmp, imgPath, ec);
+        return !ec;
+    }
+};
+
+
+/*******************************************************************************************************************
+
+                            I/O WINDOW
+    ------------------------------------------------------------------
+     address        register    load                            store
+    ------------------------------------------------------------------
+     base + 0       IO_OUT      free words in the result FIFO   appends to the result FIFO
+     base + 1       IO_IN       next input word, 0 if none      -
+     base + 2       IO_AVAIL    input words queued              -
+     base + 3       IO_TIMER    clocks since the last store,    restarts the timer, counting
+                                >> prescale                     every 2^(value & 15) clocks
+    ------------------------------------------------------------------
+     base = Size() - IO_WORDS, i.e. 252-255 in the default geometry. Loads and stores
+     saturate or mask to the data width.
+    ------------------------------------------------------------------
+
+    Computer::AttachIo(&window) maps the four words at the top of memory to an IoWindow.
+    Every M_GPR/GPR_M access to them goes to the device and not to the store: ADD,
+    ADDI (the pointer and the operand), STA and ISZ, as well as JMPI and CSR. Nothing
+    changes while no window is attached, and debugger reads (Read(), ReadMem(),
+    DisplayMemory()) always see the store. Only the microcoded machine has the window. FastCpu, LaneCpu and
+    MultiComputer cores still treat these words as plain memory.
+
+    The host is called once per block and not once per word. An input queue that runs dry
+    asks IoPort::Fill() for up to 'block' words, and a result FIFO that reaches 'block'
+    words is handed to IoPort::Drain() in one call. A halt hands over the rest of the
+    FIFO. Without a port, Feed() and TakeOutput() move whole vectors between Run() calls.
+    The guest can poll IO_AVAIL and wait for data, so a host can keep feeding a
+    running machine without a restart. The FIFO holds at most IO_FIFO_MAX words while
+    nobody drains it, and later stores are counted as dropped. The queues are host
+    state. Reset() only restarts the timer, and snapshots do not include the window.
+
+*******************************************************************************************************************/
+
+#define IO_WORDS            4           // registers of the window, at the top of the address space
+#define IO_BLOCK_WORDS      256         // default transfer size of IoPort::Fill()/Drain()
+#define IO_FIFO_MAX         65536       // result words kept without a port before stores are dropped
+
+enum IoRegister { IO_OUT = 0, IO_IN, IO_AVAIL, IO_TIMER };
+
+class IoPort                            // host side of an IoWindow; both calls move whole blocks
+{
+public:
+
+    virtual ~IoPort() {}
+    virtual size_t Fill(WORD*, size_t) { return 0; }    // input ran dry: up to (words, max), returns the count, 0 = none yet
+    virtual void Drain(const WORD*, size_t) {}          // (words, n) of the result FIFO, oldest first
+};
+
+struct IoStats
+{
+    uint64_t fed;                       // words queued by Feed() or Fill()
+    uint64_t read;                      // IO_IN loads that returned a word
+    uint64_t empty;                     // IO_IN loads with nothing queued
+    uint64_t fills;                     // Fill() calls
+    uint64_t written;                   // IO_OUT stores kept
+    uint64_t dropped;                   // IO_OUT stores lost to a full FIFO
+    uint64_t drains;                    // Drain() calls
+};
+
+class IoWindow
+{
+private:
+    IoPort* mPort;
+    size_t mBlock;
+    std::vector<WORD> mIn;              // input queue, consumed from mInHead
+    size_t mInHead;
+    std::vector<WORD> mOut;             // result FIFO
+    const uint64_t* mClock;             // clocks of the Computer it is attached to
+    uint64_t mTimerStart;
+    BYTE mPrescale;
+    WORD mDataMask;
+    IoStats mStats;
+
+    bool Refill()                       // true if input is queued, asking the port once if the queue is empty
+    {
+        if (mInHead < mIn.size()) return true;
+        mIn.clear();
+        mInHead = 0;
+        if (!mPort) return false;
+        mIn.resize(mBlock);
+        mIn.resize(mPort->Fill(mIn.data(), mBlock));
+        mStats.fills++;
+        mStats.fed += mIn.size();
+        return !mIn.empty();
+    }
+
+public:
+
+    IoWindow(IoPort* port = nullptr, size_t block = IO_BLOCK_WORDS)
+    : mPort(port), mBlock(block ? block : IO_BLOCK_WORDS), mInHead(0), mClock(nullptr), mTimerStart(0), mPrescale(0),
+      mDataMask(Geometry().dataMask), mStats()
+    {
+        mOut.reserve(mBlock);
+    }
+
+    void Bind(const uint64_t* clock, const Geometry& g)    // by Computer::AttachIo()
+    {
+        mClock = clock;
+        mDataMask = g.dataMask;
+        Restart();
+    }
+
+    void Restart()                      // timer back to 0 at clock 0, counting every clock
+    {
+        mTimerStart = 0;
+        mPrescale = 0;
+    }
+
+    WORD Load(WORD reg)                 // the guest reads register reg (M_GPR)
+    {
+        switch (reg)
+        {
+        case IO_OUT:
+            return (WORD)std::min<size_t>(mPort ? mDataMask : IO_FIFO_MAX - mOut.size(), mDataMask);
+        case IO_IN:
+            if (!Refill())
+            {
+                mStats.empty++;
+                return 0;
+            }
+            mStats.read++;
+            return mIn[mInHead++] & mDataMask;
+        case IO_AVAIL:
+            Refill();
+            return (WORD)std::min<size_t>(mIn.size() - mInHead, mDataMask);
+        default:
+            return (WORD)(((*mClock - mTimerStart) >> mPrescale) & mDataMask);
+        }
+    }
+
+    void Store(WORD reg, WORD data)     // the guest writes register reg (GPR_M)
+    {
+        if (reg == IO_OUT)
+        {
+            if (!mPort && mOut.size() >= IO_FIFO_MAX)
+            {
+                mStats.dropped++;
+                return;
+            }
+            mOut.push_back(data);
+            mStats.written++;
+            if (mPort && mOut.size() >= mBlock) Flush();
+        }
+        else if (reg == IO_TIMER)
+        {
+            mTimerStart = *mClock;
+            mPrescale = data & 15;
+        }
+    }
+
+    void Flush()                        // hands the FIFO to the port, if there is one and it is not empty
+    {
+        if (!mPort || mOut.empty()) return;
+        mPort->Drain(mOut.data(), mOut.size());
+        mStats.drains++;
+        mOut.clear();
+    }
+
+    void Feed(const WORD* words, size_t n)  // appends to the input queue; the machine may be running between calls
+    {
+        mIn.erase(mIn.begin(), mIn.begin() + mInHead);
+        mInHead = 0;
+        mIn.insert(mIn.end(), words, words + n);
+        mStats.fed += n;
+    }
+
+    size_t TakeOutput(std::vector<WORD>& words)     // appends the FIFO to words and empties it; returns words taken
+    {
+        size_t n = mOut.size();
+        words.insert(words.end(), mOut.begin(), mOut.end());
+        mOut.clear();
+        return n;
+    }
+
+    size_t Pending()                    // input words queued
+    {
+        return mIn.size() - mInHead;
+    }
+
+    const IoStats& Stats()
+    {
+        return mStats;
+    }
+
+    void Display(WORD base, std::ostream& os = std::cout)
+    {
+        os << "\n****** I/O WINDOW ****** M[" << base << ".." << (base + IO_WORDS - 1) << "], blocks of " << mBlock << "\n";
+        os << "in : " << mStats.fed << " fed, " << mStats.read << " read, " << mStats.empty << " empty reads, "
+           << mStats.fills << " fills, " << Pending() << " queued\n";
+        os << "out: " << mStats.written << " written, " << mStats.drains << " drains, " << mOut.size() << " held, "
+           << mStats.dropped << " dropped\n";
+    }
+};
+
+
+class Memory : public Component
+{
+private:
+    WORD* mStore;				    // page 0 = CoreState::mem, 16 bit (12-bit used by default)
+    std::vector<std::unique_ptr<WORD[]>> mPages;   // one entry per page, allocated on the first store; entry 0 unused
+    std::vector<WORD> mImage;       // image as loaded, restored by Reload()
+    IoWindow* mIo;                  // nullptr = no I/O window
+    WORD mIoBase;                   // first window address, mSize without one
+    WORD& mDataBus;
+    DWORD& mControlBus;
+    DWORD mInMask, mOutMask;
+    WORD& mMAR;
+    WORD mSize;
+    WORD n_size;
+    uint64_t mDirty[(1 << ADDR_BITS_MAX) / 64];  // one bit per word written since the last TakeChanges() or Load()/Reload()
+
+    WORD* Page(WORD addr)           // storage of a page above 0, allocated here
+    {
+        std::unique_ptr<WORD[]>& p = mPages[addr >> PAGE_BITS];
+        if (!p) p.reset(new WORD[PAGE_WORDS]());
+        return p.get();
+    }
+
+    void Loaded(WORD n)                     // mImage[0..n) holds the new image and the rest is 0: on to the store
+    {
+        n_size = n;
+        for (WORD a = PAGE_WORDS; a < n; a += PAGE_WORDS)  // pages holding part of the image
+        {
+            if (std::any_of(&mImage[a], &mImage[a] + PAGE_WORDS, [](WORD w) { return w != 0; })) Page(a);
+        }
+        Reload();
+    }
+
+public:
+
+    static constexpr BYTE Phases = PHASE_HIGH | PHASE_LOW;
+
+    Memory(CoreState& s, const Geometry& g, DWORD inmask, DWORD outmask)
+	: mStore(s.mem), mPages((g.words + PAGE_WORDS - 1) / PAGE_WORDS), mImage(g.words, 0), mIo(nullptr), mIoBase(g.words),
+	  mDataBus(s.bus), mControlBus(s.control),
+	  mInMask(inmask), mOutMask(outmask), mMAR(s.reg[REG_MAR]), mSize(g.words)
+	{
+        memset(mDirty, 0, sizeof(mDirty));
+        Load(DefaultProgram, sizeof(DefaultProgram)/sizeof(WORD));
+	}
+
+    void HighLevel()
+	{
+		if (mControlBus & mOutMask)
+		{
+			mDataBus = (mMAR < mIoBase) ? Read(mMAR) : mIo->Load(mMAR - mIoBase);		// RAM -> BUS
+		}
+	}
+
+	BYTE Reacts(DWORD control)
+	{
+	    return ((control & mOutMask) ? PHASE_HIGH : 0) | ((control & mInMask) ? PHASE_LOW : 0);
+	}
+
+	void LowLevel()
+	{
+	    if (mControlBus & mInMask)
+		{
+            if (mMAR >= mIoBase)
+            {
+                mIo->Store(mMAR - mIoBase, mDataBus);
+                return;
+            }
+            Write(mMAR, mDataBus);	     // BUS -> RAM																																	// 0x0000-0x7fff: schreiben in RAM
+		}
+	}
+
+    void Attach(IoWindow* io)       // maps the top IO_WORDS addresses to io; nullptr = plain memory again
+    {
+        mIo = io;
+        mIoBase = io ? (WORD)(mSize - IO_WORDS) : mSize;
+    }
+
+    IoWindow* Io()
+    {
+        return mIo;
+    }
+
+    WORD IoBase()                   // first window address
+    {
+        return (WORD)(mSize - IO_WORDS);
+    }
+
+    WORD Read(WORD addr)            // MAR is masked to the address width, so addr < Size()
+    {
+        if (addr < PAGE_WORDS)
+        {
+            return mStore[addr];
+        }
+        const WORD* p = mPages[addr >> PAGE_BITS].get();
+        return p ? p[addr & (PAGE_WORDS - 1)] : 0;
+    }
+
+    void Write(WORD addr, WORD data)
+    {
+        mDirty[addr >> 6] |= 1ull << (addr & 63);
+        if (addr < PAGE_WORDS)
+        {
+            mStore[addr] = data;
+            return;
+        }
+        Page(addr)[addr & (PAGE_WORDS - 1)] = data;
+    }
+
+	void Set(WORD& data)
+    {
+        Write(mMAR, data);
+    }
+
+    void Load(const WORD* image, WORD n)    // replaces the whole store, words past n are cleared
+    {
+        if (n > mSize) n = mSize;
+        std::copy(image, image + n, mImage.begin());
+        std::fill(mImage.begin() + n, mImage.end(), 0);
+        Loaded(n);
+    }
+
+    void Load(ProgramImage& image)          // decodes the mapped file into the image, then the store
+    {
+        WORD n = (WORD)std::min(image.Words(), (size_t)mSize);
+        for (WORD i = 0; i < n; i++)
+        {
+            mImage[i] = image.Word(i);
+        }
+        std::fill(mImage.begin() + n, mImage.end(), 0);
+        Loaded(n);
+    }
+
+    void Reload()                           // back to the image as loaded, undoing the program's stores
+    {
+        memset(mDirty, 0, (mSize + 63) / 64 * sizeof(uint64_t));
+        memcpy(mStore, mImage.data(), std::min<size_t>(mSize, PAGE_WORDS) * sizeof(WORD));
+        for (size_t p = 1; p < mPages.size(); p++)
+        {
+            if (mPages[p]) memcpy(mPages[p].get(), &mImage[p * PAGE_WORDS], PAGE_WORDS * sizeof(WORD));
+        }
+    }
+
+    WORD Get()
+    {
+        return Read(mMAR);
+    }
+
+    const WORD* Data()                      // page 0, the whole store unless Paged()
+    {
+        return mStore;
+    }
+
+    WORD Size()                             // words in the address space
+    {
+        return mSize;
+    }
+
+    bool Paged()
+    {
+        return mSize > PAGE_WORDS;
+    }
+
+    void SavePages(std::vector<WORD>& pages, std::vector<WORD>& data)  // the pages above 0 in use, see Snapshot
+    {
+        pages.clear();
+        data.clear();
+        for (size_t p = 1; p < mPages.size(); p++)
+        {
+            if (!mPages[p]) continue;
+            pages.push_back((WORD)p);
+            data.insert(data.end(), mPages[p].get(), mPages[p].get() + PAGE_WORDS);
+        }
+    }
+
+    bool RestorePages(const std::vector<WORD>& pages, const std::vector<WORD>& data)  // unlisted pages read as zero again
+    {
+        if (data.size() != pages.size() * PAGE_WORDS) return false;
+        for (WORD p : pages)
+        {
+            if (p == 0 || p >= mPages.size()) return false;
+        }
+        for (size_t p = 1; p < mPages.size(); p++)
+        {
+            if (mPages[p]) memset(mPages[p].get(), 0, PAGE_WORDS * sizeof(WORD));
+        }
+        for (size_t i = 0; i < pages.size(); i++)
+        {
+            memcpy(Page((WORD)(pages[i] << PAGE_BITS)), &data[i * PAGE_WORDS], PAGE_WORDS * sizeof(WORD));
+        }
+        return true;
+    }
+
+    size_t TakeChanges(std::vector<WORD>& addrs)    // addresses written since the last call, ascending; clears the marks
+    {
+        addrs.clear();
+        for (size_t i = 0; i < (mSize + 63) / 64u; i++)
+        {
+            for (uint64_t m = mDirty[i]; m; m &= m - 1)
+            {
+                DWORD lo = (DWORD)m, hi = (DWORD)(m >> 32);
+                BYTE bit = lo ? LineIndex(lo & (0u - lo)) : (BYTE)(32 + LineIndex(hi & (0u - hi)));
+                addrs.push_back((WORD)(i * 64 + bit));
+            }
+            mDirty[i] = 0;
+        }
+        return addrs.size();
+    }
+
+    void MarkAll()                          // every word counts as written, e.g. after a restore
+    {
+        memset(mDirty, 0xff, (mSize + 63) / 64 * sizeof(uint64_t));
+    }
+
+    size_t PagesInUse()                     // including page 0
+    {
+        return 1 + std::count_if(mPages.begin() + 1, mPages.end(), [](const std::unique_ptr<WORD[]>& p) { return p != nullptr; });
+    }
+
+    void DisplayMemory(std::ostream& os = std::cout)
+    {
+        os << "\n****** WORD n_size ****** : " << (int)n_size << "\n";
+
+        for (int i = 0; i < n_size; i++)
+        {
+            os << Read(i) << " - " ;
+        }
+    }
+
+};
+
+
+
+/*******************************************************************************************************************
+
+                            INSTRUCTIONS [Fetch Cycle]
+    ------------------------------------------------------------------
+     Clock cycle    Microoperation             Explanation
+    ------------------------------------------------------------------
+        1           PC -> MAR       [PC_MAR]        Transfer instruction location
+                                                    from program counter to memory
+                                                    address register
+
+        2           M -> GPR        [M_GPR]         Transfer addressed word to
+                    PC+1 -> PC      [INCPC]         general-purpose register: increment
+                                                    program counter
+
+        3           GPR(OP) -> OPR  [GPR_OP]        Transfer operation part of
+                                                    instruction to operation register
+    ----------------------------------------------------------------------
+
+     INSTRUCTIONS [Execute Cycle]
+    ------------------------------------------------------------------------
+     Mnemonic      Explanation                         Microoperation
+    ------------------------------------------------------------------------
+        CRA        Clear accumulator                    0 -> Acc        [CLRA]
+                                                        0 -> SC         [CLRSC]  -  Clear Sequence Counter (2 clock cycle)
+
+        CTA        Complement accumulator               ~Acc -> Acc     [COMA]
+                                                        0 -> SC         [CLRSC]
+
+        ITA        Increment accumulator                Acc + 1 -> Acc  [INCA]
+                                                        0 -> SC         [CLRSC]
+
+        CRF        Clear flip-flop F                    0 -> F          [CLRF]
+                                                        0 -> SC         [CLRSC]
+
+        CTF        Complement flip-flop F               ~F -> F         [COMF]
+                                                        0 -> SC         [CLRSC]
+
+        SFZ         Skip next instruction               PC + 1 -> PC    [INCPCF]  (if F = 0)
+                        if F is zero                    0 -> SC         [CLRSC]
+
+
+        ROR         Rotate right through                Rotate right    [ROR]
+                        F and Acc                       0 -> SC         [CLRSC]
+
+        ROL         Rotate left through                 Rotate left     [ROL]
+                        F and Acc                       0 -> SC         [CLRSC]
+
+        HLT         HALT                                HLT             [HLT]
+    ------------------------------------------------------------------------
+
+
+    INSTRUCTIONS [Execute Cycle]
+    ------------------------------------------------------------------------
+     Mnemonic               Clock cycle            Microoperation
+    ------------------------------------------------------------------------
+    ADD ,Address    :           1                   GPR(AD) -> MAR      [GPR_MAR]
+
+                                2                   M > GPR            [M_GPR]
+
+                                3                   GPR + Acc -> Acc    [ADD]
+
+                                4                   0 -> SC             [CLRSC]
+    ------------------------------------------------------------------------
+
+    INSTRUCTIONS [Execute Cycle]
+    ------------------------------------------------------------------------
+     Mnemonic               Clock cycle            Microoperation
+    ------------------------------------------------------------------------
+    ADDI ,Address    :          1                   GPR(AD) -> MAR      [GPR_MAR]
+
+                                2                   M > GPR            [M_GPR]
+
+                                3                   GPR(AD) -> MAR      [GPR_MAR]
+
+                                4                   M > GPR            [M_GPR]
+
+                                5                   GPR + Acc -> Acc    [ADD]
+
+                                6                   0 -> SC             [CLRSC]
+    ------------------------------------------------------------------------
+
+    INSTRUCTIONS [Execute Cycle]
+    ------------------------------------------------------------------------
+     Mnemonic               Clock cycle            Microoperation
+    ------------------------------------------------------------------------
+    STA ,Address    :           1                   GPR(AD) -> MAR      [GPR_MAR]
+
+                                2                   Acc > GPR          [A_GPR]
+
+                                3                   GPR -> M            [GPR_M]
+
+                                4                   0 -> SC             [CLRSC]
+    ------------------------------------------------------------------------
+
+    INSTRUCTIONS [Execute Cycle]
+    ------------------------------------------------------------------------
+     Mnemonic               Clock cycle            Microoperation
+    ------------------------------------------------------------------------
+    JMP ,Address    :           1                   GPR(AD) -> PC       [GPR_PC]
+
+                                2                   0 -> SC             [CLRSC]
+    ------------------------------------------------------------------------
+
+    INSTRUCTIONS [Execute Cycle]
+    ------------------------------------------------------------------------
+     Mnemonic               Clock cycle            Microoperation
+    ------------------------------------------------------------------------
+    JMPI ,Address    :          1                   GPR(AD) -> MAR      [GPR_MAR]
+
+                                2                   M > GPR            [M_GPR]
+
+                                3                   GPR(AD) -> PC       [GPR_PC]
+
+                                4                   0 -> SC             [CLRSC]
+    ------------------------------------------------------------------------
+
+    INSTRUCTIONS [Execute Cycle]
+    ------------------------------------------------------------------------
+     Mnemonic               Clock cycle            Microoperation
+    ------------------------------------------------------------------------
+    CSR ,Address    :           1                   GPR(AD) -> MAR      [GPR_MAR]
+
+                                2                   GPR(AD) -> PC       [GPR_PC]
+                                                    PC -> GPR(AD)       [PC_GPR]
+
+                                3                   GPR(AD) -> M        [GPR_M]
+
+                                4                   PC + 1 -> PC        [INCPC]
+
+                                5                   0 -> SC             [CLRSC]
+    ------------------------------------------------------------------------
+
+    INSTRUCTIONS [Execute Cycle]
+    ------------------------------------------------------------------------
+     Mnemonic               Clock cycle            Microoperation
+    ------------------------------------------------------------------------
+    ISZ ,Address    :           1                   GPR(AD) -> MAR      [GPR_MAR]
+
+                                2                   M -> GPR            [M_GPR]
+
+                                3                   GPR + 1 -> GPR      [INCGPR]
+
+                                4                   GPR -> M            [GPR_M]
+
+                                5                   PC + 1 -> PC        [INCPCZ] (if GPR = 0 or Z = 1)
+
+                                6                   0 -> SC             [CLRSC]
+    ------------------------------------------------------------------------
+
+*******************************************************************************************************************/
+
+/*******************************************************************************************************************
+
+                            PERFORMANCE COUNTERS
+    ------------------------------------------------------------------
+     Counter            Counted in Control::RisingEdge() when
+    ------------------------------------------------------------------
+     clocks             every clock
+     instructions       CLRSC or HLT: one instruction retired
+     opCount[op]        as above, per opcode (mOpcode)
+     opCycles[op]       as above, adds SC: fetch + execute clocks of the instruction
+     sfzTaken/NotTaken  INCPCF with F = 0 / F = 1
+     iszTaken/NotTaken  INCPCZ with Z = 1 / Z = 0
+     memReads           M_GPR
+     memWrites          GPR_M
+    ------------------------------------------------------------------
+
+    All counters restart with Control::Reset(). Computer::Counters() returns a copy,
+    so two snapshots can be subtracted to measure a stretch of a run.
+
+    Computer::SetProfiling(true) adds one more: the CLRSC clock also fetches the next
+    instruction, so it counts the address in PC (see PROFILER).
+
+*******************************************************************************************************************/
+
+struct PerfCounters
+{
+    uint64_t clocks;
+    uint64_t instructions;
+    uint64_t opCount[16];
+    uint64_t opCycles[16];
+    uint64_t sfzTaken, sfzNotTaken;
+    uint64_t iszTaken, iszNotTaken;
+    uint64_t memReads, memWrites;
+};
+
+inline void DisplayCounters(const PerfCounters& pc, std::ostream& os)     // end-of-run summary, hottest opcodes first
+{
+    BYTE order[16];
+    for (int i = 0; i < 16; i++) order[i] = (BYTE)i;
+    std::stable_sort(order, order + 16, [&](BYTE a, BYTE b) { return pc.opCycles[a] > pc.opCycles[b]; });
+
+    os << "\n****** COUNTERS ******\n";
+    os << "clocks       : " << pc.clocks << "\n";
+    os << "instructions : " << pc.instructions << "\n";
+    os << "CPI          : " << (pc.instructions ? (double)pc.clocks / pc.instructions : 0.0) << "\n";
+    os << "mem reads    : " << pc.memReads << "\n";
+    os << "mem writes   : " << pc.memWrites << "\n";
+    os << "SFZ skips    : " << pc.sfzTaken << " taken / " << pc.sfzNotTaken << " not taken\n";
+    os << "ISZ skips    : " << pc.iszTaken << " taken / " << pc.iszNotTaken << " not taken\n";
+    for (BYTE op : order)
+    {
+        if (pc.opCount[op] == 0) continue;
+        os << OpcodeTable[op].mnemonic << "\t" << pc.opCount[op] << " x, " << pc.opCycles[op] << " clocks ("
+           << (pc.clocks ? 100.0 * pc.opCycles[op] / pc.clocks : 0.0) << "%)\n";
+    }
+}
+
+/*******************************************************************************************************************
+
+                            MICROCODE ROM
+    ------------------------------------------------------------------
+     address    0 - 2                   fetch, shared by all instructions
+                OpcodeTable[op].slot    execute steps of op from SC = 3, 8 words per slot
+    ------------------------------------------------------------------
+
+    The ROM is written as symbolic microoperation lists and assembled by BuildRom() at
+    compile time into read-only storage. The static_asserts below reject microcode in
+    which a slot does not end in CLRSC, two sources drive the bus in the same step, or
+    Adder/GprBus get more than one of their lines at once (they act on exactly one).
+
+*******************************************************************************************************************/
+
+#define ROM_SIZE        136
+#define SLOT_STEPS      8
+
+#define BUS_FROM_GPR    (GPR_M | GPR_MAR | GPR_OP | GPR_PC)     // lines on which a source drives the bus
+#define BUS_FROM_PC     (PC_MAR | PC_GPR)
+#define BUS_FROM_MEM    (M_GPR)
+#define ALU_LINES       (ADD | ROL | ROR | COMA | COMF | CLRA | CLRF | A_GPR)
+#define GBUS_LINES      (PC_GPR | GPR_OP)
+
+struct MicroSlot
+{
+    BYTE opcode;
+    DWORD step[SLOT_STEPS];             // unused steps 0
+};
+
+constexpr DWORD MicroFetch[3] =
+{
+    PC_MAR,                             // 0 PC -> MAR
+    M_GPR | INCPC,                      // 1 M -> GPR, PC + 1 -> PC
+    GPR_OP,                             // 2 GPR(OP) -> OPR
+};
+
+constexpr MicroSlot MicroSlots[] =
+{
+    { OPC_CRA,  { CLRA, CLRSC } },                              // 0 -> Acc
+    { OPC_CTA,  { COMA, CLRSC } },                              // ~Acc -> Acc
+    { OPC_ITA,  { INCA, CLRSC } },                              // Acc + 1 -> Acc
+    { OPC_CRF,  { CLRF, CLRSC } },                              // 0 -> F
+    { OPC_CTF,  { COMF, CLRSC } },                              // ~F -> F
+    { OPC_SFZ,  { INCPCF, CLRSC } },                            // PC + 1 -> PC if F = 0
+    { OPC_ROR,  { ROR, CLRSC } },                               // rotate right through F
+    { OPC_ROL,  { ROL, CLRSC } },                               // rotate left through F
+    { OPC_ADD,  { GPR_MAR, M_GPR, ADD, CLRSC } },               // GPR -> MAR, M -> GPR, GPR + Acc -> Acc
+    { OPC_ADDI, { GPR_MAR, M_GPR, GPR_MAR, M_GPR, ADD, CLRSC } },   // as ADD, through one pointer
+    { OPC_STA,  { GPR_MAR, A_GPR, GPR_M, CLRSC } },             // GPR -> MAR, Acc -> GPR, GPR -> M
+    { OPC_JMP,  { GPR_PC, CLRSC } },                            // GPR -> PC
+    { OPC_JMPI, { GPR_MAR, M_GPR, GPR_PC, CLRSC } },            // GPR -> MAR, M -> GPR, GPR -> PC
+    { OPC_CSR,  { GPR_MAR, PC_GPR, GPR_M, INCPC, CLRSC } },     // GPR -> MAR, PC -> GPR, GPR -> M, PC + 1 -> PC
+    { OPC_ISZ,  { GPR_MAR, M_GPR, INCGPR, GPR_M, INCPCZ, CLRSC } }, // M + 1 -> M, PC + 1 -> PC if Z = 1
+    { OPC_HLT,  { HLT, CLRSC } },
+};
+
+struct MicroRom
+{
+    DWORD word[ROM_SIZE];
+};
+
+constexpr MicroRom BuildRom()
+{
+    MicroRom rom = {};
+    for (int i = 0; i < 3; i++)
+    {
+        rom.word[i] = MicroFetch[i];
+    }
+    for (const MicroSlot& s : MicroSlots)
+    {
+        for (int i = 0; i < SLOT_STEPS; i++)
+        {
+            rom.word[OpcodeTable[s.opcode].slot + i] = s.step[i];
+        }
+    }
+    return rom;
+}
+
+constexpr MicroRom Microcode = BuildRom();
+
+constexpr int Bits(DWORD w)
+{
+    int n = 0;
+    for (; w; w &= w - 1) n++;
+    return n;
+}
+
+constexpr bool SlotsComplete()          // each opcode has exactly one slot
+{
+    int seen[16] = {};
+    for (const MicroSlot& s : MicroSlots)
+    {
+        if (s.opcode > 15 || seen[s.opcode]++) return false;
+    }
+    for (int n : seen)
+    {
+        if (n != 1) return false;
+    }
+    return true;
+}
+
+constexpr bool SlotsEndInClrsc()        // CLRSC is the last non-empty step and appears nowhere else
+{
+    for (const MicroSlot& s : MicroSlots)
+    {
+        int last = -1;
+        for (int i = 0; i < SLOT_STEPS; i++)
+        {
+            if (s.step[i]) last = i;
+        }
+        if (last < 0 || s.step[last] != CLRSC) return false;
+        for (int i = 0; i < last; i++)
+        {
+            if (s.step[i] == 0 || (s.step[i] & CLRSC)) return false;
+        }
+    }
+    return true;
+}
+
+constexpr bool StepClean(DWORD w)       // at most one bus source, one Adder line, one GprBus line
+{
+    int sources = ((w & BUS_FROM_GPR) != 0) + ((w & BUS_FROM_PC) != 0) + ((w & BUS_FROM_MEM) != 0);
+    return sources <= 1 && Bits(w & ALU_LINES) <= 1 && Bits(w & GBUS_LINES) <= 1;
+}
+
+constexpr bool RomClean()
+{
+    for (DWORD w : Microcode.word)
+    {
+        if (!StepClean(w)) return false;
+    }
+    return true;
+}
+
+static_assert(SlotsComplete(), "microcode: every opcode needs exactly one slot");
+static_assert(SlotsEndInClrsc(), "microcode: every slot must end in CLRSC, with no gaps before it");
+static_assert(RomClean(), "microcode: conflicting bus drivers or Adder/GprBus lines in one step");
+
+
+/*******************************************************************************************************************
+
+                            MICROCODE DISPATCH
+    ------------------------------------------------------------------
+     index = SC << 6 | OPR << 2 | F register (0b ZF)        1024 entries, one per (step, opcode, Z, F)
+    ------------------------------------------------------------------
+
+    BuildDispatch() compiles the ROM at compile time into Dispatch: each entry holds the final
+    control word of that clock (INCPC already merged in for a taken SFZ/ISZ skip, the
+    fetch step 0 word already substituted on CLRSC) and the events Control has to act
+    on. Control::RisingEdge() is one lookup; SC <= 2 entries repeat the fetch words
+    for every opcode. Steps past the end of a slot (only reachable by stepping on after
+    HLT) read as 0.
+
+*******************************************************************************************************************/
+
+#define MOP_CLRSC       0x01            // last execute step: reset SC (entry holds fetch step 0)
+#define MOP_HALT        0x02
+#define MOP_RETIRE      0x04            // instruction retired on this clock (CLRSC or HLT)
+#define MOP_SKIP        0x08            // INCPCF/INCPCZ step ...
+#define MOP_TAKEN       0x10            // ... whose skip was taken
+#define MOP_ISZ         0x20            // skip step belongs to ISZ (else SFZ)
+
+struct MicroOp
+{
+    DWORD control;
+    BYTE events;
+};
+
+constexpr WORD DispatchIndex(WORD sc, WORD opr, WORD flg)
+{
+    return ((sc & 0x000f) << 6) | ((opr & 0x000f) << 2) | (flg & 0x0003);
+}
+
+struct MicroDispatch
+{
+    MicroOp op[1024];
+};
+
+constexpr MicroDispatch BuildDispatch()
+{
+    MicroDispatch t = {};
+    for (WORD sc = 0; sc < 16; sc++)
+    {
+        for (WORD op = 0; op < 16; op++)
+        {
+            for (WORD flg = 0; flg < 4; flg++)
+            {
+                WORD addr = (sc > 2) ? (OpcodeTable[op].slot | (sc - 3)) : sc;
+                DWORD c = (addr < ROM_SIZE) ? Microcode.word[addr] : 0;
+                BYTE ev = 0;
+
+                if (c & INCPCF)
+                {
+                    ev |= MOP_SKIP;
+                    if (!(flg & 0x0001)) { c |= INCPC; ev |= MOP_TAKEN; }
+                }
+                if (c & INCPCZ)
+                {
+                    ev |= MOP_SKIP | MOP_ISZ;
+                    if (flg & 0x0002) { c |= INCPC; ev |= MOP_TAKEN; }
+                }
+                if (c & (CLRSC | HLT)) ev |= MOP_RETIRE;
+                if (c & CLRSC)
+                {
+                    ev |= MOP_CLRSC;
+                    c = Microcode.word[0];
+                }
+                if (c & HLT) ev |= MOP_HALT;
+
+                MicroOp& m = t.op[DispatchIndex(sc, op, flg)];
+                m.control = c;
+                m.events = ev;
+            }
+        }
+    }
+    return t;
+}
+
+constexpr MicroDispatch Dispatch = BuildDispatch();
+
+class Control : public Component
+{
+private:
+
+	BYTE& mOpcode;
+	WORD mIndex;                        // dispatch index of the current clock
+	WORD& mDataBus;                     // reference to the IO lines the component is connected to
+    DWORD& mControlBus;                  // reference to the control word
+	WORD& mRegOpr;
+	WORD& mRegSteps;
+	WORD& mRegFlg;
+	WORD& mRegPc;
+    BYTE& mHalted;                      // set by HLT, cleared by Reset()
+    PerfCounters mCounters;
+    uint64_t* mProfile;                 // per-address instruction counts (Computer::SetProfiling), nullptr = off
+
+public:
+
+    static constexpr BYTE Phases = PHASE_RISING;
+
+    Control(CoreState& s)
+	: mOpcode(s.opcode), mIndex(0), mDataBus(s.bus), mControlBus(s.control), mRegOpr(s.reg[REG_OPR]), mRegSteps(s.reg[REG_SC]), mRegFlg(s.reg[REG_F]), mRegPc(s.reg[REG_PC]), mHalted(s.halted), mProfile(nullptr)
+	{
+        mHalted = 0;
+        memset(&mCounters, 0, sizeof(mCounters));
+	}
+
+	void RisingEdge()
+	{
+        WORD sc = mRegSteps;
+
+		if (sc > 2)
+        {
+            mOpcode = (BYTE)(mRegOpr);
+        }
+        mIndex = DispatchIndex(sc, mRegOpr, mRegFlg);
+
+        const MicroOp& m = Dispatch.op[mIndex];
+        mControlBus = m.control;
+        mCounters.clocks++;
+        mCounters.memReads += (m.control & M_GPR) != 0;
+        mCounters.memWrites += (m.control & GPR_M) != 0;
+
+        if (m.events)
+        {
+            if (m.events & MOP_SKIP)
+            {
+                if (m.events & MOP_ISZ) ((m.events & MOP_TAKEN) ? mCounters.iszTaken : mCounters.iszNotTaken)++;
+                else ((m.events & MOP_TAKEN) ? mCounters.sfzTaken : mCounters.sfzNotTaken)++;
+            }
+            if (m.events & MOP_RETIRE)  // SC = fetch + execute clocks of the instruction
+            {
+                mCounters.instructions++;
+                mCounters.opCount[mOpcode & 0x0f]++;
+                mCounters.opCycles[mOpcode & 0x0f] += sc;
+            }
+            if (m.events & MOP_CLRSC)   // immediate asnychroneous reset
+            {
+                mRegSteps = 0;
+                if (mProfile) mProfile[mRegPc]++;   // this clock fetches the instruction at PC
+            }
+            if (m.events & MOP_HALT)
+            {
+                mHalted = 1;         // the run loops stop stepping once this is set
+            }
+        }
+	}
+
+    void Reset()
+    {
+        mControlBus = 0;
+        mOpcode = 0;
+        mHalted = 0;
+        memset(&mCounters, 0, sizeof(mCounters));
+        mIndex = 0;
+    }
+
+    bool Halted()
+    {
+        return mHalted;
+    }
+
+    const PerfCounters& Counters()
+    {
+        return mCounters;
+    }
+
+    void SetCounters(const PerfCounters& c)     // RestoreSnapshot()
+    {
+        mCounters = c;
+    }
+
+    void SetProfile(uint64_t* counts)   // one entry per address, nullptr = off
+    {
+        mProfile = counts;
+    }
+
+    WORD Index()                        // dispatch index of the last clock, see DispatchIndex()
+    {
+        return mIndex;
+    }
+
+    BYTE Reacts(DWORD)
+    {
+        return PHASE_RISING;
+    }
+
+    BYTE Opcode()
+    {
+        return mOpcode;
+    }
+
+};
+
+
+/*******************************************************************************************************************
+
+                            BINARY TRACE
+    ------------------------------------------------------------------
+     file           content
+    ------------------------------------------------------------------
+     header         DWORD TRACE_FILE_MAGIC ("TBTR"), DWORD TRACE_FILE_VERSION,
+                    uint64 cycle of the first record
+     record         BYTE mask, then the fields whose mask bit is set, in bit order:
+      bit 0         control   BYTE slot of the control word dictionary, or 0xff and
+                              the DWORD (added to the next free slot, up to 127)
+      bit 1-5       bus, PC, MAR, GPR, Acc: the change from the previous record as a
+                              zigzag LEB128 varint (1 byte for -64..63)
+      bit 6         F         BYTE
+      bit 7         SC, OPR   BYTE OPR << 4 | SC; without it SC = previous + 1, OPR kept
+     resync         mask 0x01, control byte 0xfe, varint cycle; the next record
+                    starts from all zero fields (after Reset() or a restore)
+    ------------------------------------------------------------------
+
+    One record per clock, state after the clock, cycle = previous + 1. A typical
+    microstep changes SC by one, the control word and one or two registers, so a record
+    is 4-6 bytes instead of about 150 characters of Dump() text.
+
+    TraceWriter encodes into one of two TRACE_STREAM_BUFFER byte buffers allocated by
+    Open(). When one is full it goes to a writer thread and the machine goes on filling
+    the other one; it only waits if the disk has not finished the buffer before. No
+    allocation or system call happens per record. TraceReader decodes a file back into
+    TraceFrames (--trace-decode).
+
+*******************************************************************************************************************/
+
+#define TRACE_FILE_MAGIC    0x52544254  // "TBTR"
+#define TRACE_FILE_VERSION  1
+#define TRACE_STREAM_BUFFER (1 << 20)   // bytes, two of them
+#define TRACE_RECORD_MAX    32          // longest record or resync
+#define TRACE_DICT_SIZE     127
+
+struct TraceFrame                       // one decoded record
+{
+    uint64_t cycle;
+    DWORD control;
+    WORD bus;
+    WORD regs[7];                       // SC, PC, MAR, OPR, GPR, Acc, F
+};
+
+class TraceWriter
+{
+private:
+    std::ofstream mOut;
+    std::unique_ptr<BYTE[]> mBuffers[2];
+    BYTE* mPut;                         // into mBuffers[mActive]
+    int mActive;
+    size_t mPendingSize;                // bytes of mBuffers[!mActive] the thread has to write, 0 = idle
+    bool mStop;
+    std::thread mThread;
+    std::mutex mLock;
+    std::condition_variable mWake;
+    TraceFrame mPrev;
+    DWORD mDict[TRACE_DICT_SIZE];
+    int mDictSize;
+    uint64_t mRecords;
+    uint64_t mBytes;
+
+    void Put(uint64_t v, int bytes)
+    {
+        for (int i = 0; i < bytes; i++) mOut.put((char)(v >> (8 * i)));
+    }
+
+    static void Varint(BYTE*& p, uint64_t v)
+    {
+        while (v >= 0x80)
+        {
+            *p++ = (BYTE)(v | 0x80);
+            v >>= 7;
+        }
+        *p++ = (BYTE)v;
+    }
+
+    static void Delta(BYTE*& p, WORD now, WORD before)  // zigzag of the 16-bit difference
+    {
+        int16_t d = (int16_t)(WORD)(now - before);
+        Varint(p, (WORD)((d << 1) ^ (d >> 15)));
+    }
+
+    void WriterThread()
+    {
+        std::unique_lock<std::mutex> g(mLock);
+        for (;;)
+        {
+            mWake.wait(g, [this] { return mPendingSize != 0 || mStop; });
+            if (mPendingSize)
+            {
+                size_t n = mPendingSize;
+                const BYTE* data = mBuffers[!mActive].get();
+                g.unlock();
+                mOut.write((const char*)data, n);
+                g.lock();
+                mPendingSize = 0;
+                mWake.notify_all();
+            }
+            else if (mStop)
+            {
+                return;
+            }
+        }
+    }
+
+    void Flip()                         // hand the active buffer to the thread, continue in the other one
+    {
+        std::unique_lock<std::mutex> g(mLock);
+        mWake.wait(g, [this] { return mPendingSize == 0; });
+        mPendingSize = mPut - mBuffers[mActive].get();
+        mBytes += mPendingSize;
+        mActive = !mActive;
+        mPut = mBuffers[mActive].get();
+        mWake.notify_all();
+    }
+
+    void Room()
+    {
+        if (mPut + TRACE_RECORD_MAX > mBuffers[mActive].get() + TRACE_STREAM_BUFFER)
+        {
+            Flip();
+        }
+    }
+
+public:
+    TraceWriter() : mPut(nullptr), mActive(0), mPendingSize(0), mStop(false), mDictSize(0), mRecords(0), mBytes(0)
+    {
+        memset(&mPrev, 0, sizeof(mPrev));
+    }
+
+    ~TraceWriter()
+    {
+        Close();
+    }
+
+    bool Open(const char* path, uint64_t cycle)     // cycle: clocks since Reset() before the first record
+    {
+        Close();
+        mOut.open(path, std::ios::binary | std::ios::trunc);
+        if (!mOut)
+        {
+            return false;
+        }
+        for (auto& b : mBuffers)
+        {
+            b.reset(new BYTE[TRACE_STREAM_BUFFER]);
+        }
+        mActive = 0;
+        mPut = mBuffers[0].get();
+        mPendingSize = 0;
+        mStop = false;
+        mDictSize = 0;
+        mRecords = mBytes = 0;
+        memset(&mPrev, 0, sizeof(mPrev));
+        Put(TRACE_FILE_MAGIC, 4);
+        Put(TRACE_FILE_VERSION, 4);
+        Put(cycle, 8);
+        mBytes = 16;
+        mThread = std::thread(&TraceWriter::WriterThread, this);
+        return true;
+    }
+
+    bool IsOpen()
+    {
+        return mPut != nullptr;
+    }
+
+    void Push(const CoreState& s)       // one clock
+    {
+        BYTE mask = 0;
+        BYTE* p;
+
+        Room();
+        p = mPut + 1;
+        if (s.control != mPrev.control)
+        {
+            int slot = 0;
+            while (slot < mDictSize && mDict[slot] != s.control) slot++;
+            mask |= 0x01;
+            if (slot < mDictSize)
+            {
+                *p++ = (BYTE)slot;
+            }
+            else
+            {
+                *p++ = 0xff;
+                for (int i = 0; i < 4; i++) *p++ = (BYTE)(s.control >> (8 * i));
+                if (mDictSize < TRACE_DICT_SIZE) mDict[mDictSize++] = s.control;
+            }
+            mPrev.control = s.control;
+        }
+        if (s.bus != mPrev.bus) mask |= 0x02, Delta(p, s.bus, mPrev.bus);
+        if (s.reg[REG_PC] != mPrev.regs[REG_PC]) mask |= 0x04, Delta(p, s.reg[REG_PC], mPrev.regs[REG_PC]);
+        if (s.reg[REG_MAR] != mPrev.regs[REG_MAR]) mask |= 0x08, Delta(p, s.reg[REG_MAR], mPrev.regs[REG_MAR]);
+        if (s.reg[REG_GPR] != mPrev.regs[REG_GPR]) mask |= 0x10, Delta(p, s.reg[REG_GPR], mPrev.regs[REG_GPR]);
+        if (s.reg[REG_ACC] != mPrev.regs[REG_ACC]) mask |= 0x20, Delta(p, s.reg[REG_ACC], mPrev.regs[REG_ACC]);
+        if (s.reg[REG_F] != mPrev.regs[REG_F]) mask |= 0x40, *p++ = (BYTE)s.reg[REG_F];
+        if (s.reg[REG_SC] != ((mPrev.regs[REG_SC] + 1) & 0x000f) || s.reg[REG_OPR] != mPrev.regs[REG_OPR])
+        {
+            mask |= 0x80;
+            *p++ = (BYTE)((s.reg[REG_OPR] << 4) | s.reg[REG_SC]);
+        }
+        *mPut = mask;
+        mPut = p;
+        mPrev.bus = s.bus;
+        memcpy(mPrev.regs, s.reg, sizeof(mPrev.regs));
+        mRecords++;
+    }
+
+    void Resync(uint64_t cycle)         // the next record is clock cycle + 1, from all zero fields
+    {
+        Room();
+        *mPut++ = 0x01;
+        *mPut++ = 0xfe;
+        Varint(mPut, cycle);
+        DWORD control = mPrev.control;
+        memset(&mPrev, 0, sizeof(mPrev));
+        mPrev.control = control;        // the dictionary and the control word carry over
+    }
+
+    bool Close()                        // flushes and waits for the disk; false if a write failed
+    {
+        if (!mPut)
+        {
+            return true;
+        }
+        Flip();
+        {
+            std::lock_guard<std::mutex> g(mLock);
+            mStop = true;
+        }
+        mWake.notify_all();
+        mThread.join();
+        mPut = nullptr;
+        mOut.close();
+        return !mOut.fail();
+    }
+
+    uint64_t Records()
+    {
+        return mRecords;
+    }
+
+    uint64_t Bytes()                    // written or handed to the thread so far
+    {
+        return mBytes + (mPut ? mPut - mBuffers[mActive].get() : 0);
+    }
+};
+
+class TraceReader
+{
+private:
+    std::ifstream mIn;
+    TraceFrame mFrame;
+    DWORD mDict[TRACE_DICT_SIZE];
+    int mDictSize;
+    const char* mError;
+
+    uint64_t Get(int bytes)
+    {
+        uint64_t v = 0;
+        for (int i = 0; i < bytes; i++) v |= (uint64_t)(BYTE)mIn.get() << (8 * i);
+        return v;
+    }
+
+    uint64_t Varint()
+    {
+        uint64_t v = 0;
+        for (int shift = 0; shift < 64; shift += 7)
+        {
+            int b = mIn.get();
+            if (b == EOF)
+            {
+                break;
+            }
+            v |= (uint64_t)(b & 0x7f) << shift;
+            if (!(b & 0x80)) return v;
+        }
+        mError = "truncated record";
+        return 0;
+    }
+
+    WORD Delta(WORD before)
+    {
+        WORD z = (WORD)Varint();
+        return (WORD)(before + (WORD)((z >> 1) ^ (0u - (z & 1))));
+    }
+
+public:
+    TraceReader() : mDictSize(0), mError(nullptr)
+    {
+        memset(&mFrame, 0, sizeof(mFrame));
+    }
+
+    bool Open(const char* path)
+    {
+        mIn.open(path, std::ios::binary);
+        if (!mIn || Get(4) != TRACE_FILE_MAGIC || Get(4) != TRACE_FILE_VERSION)
+        {
+            mError = "not a trace file";
+            return false;
+        }
+        memset(&mFrame, 0, sizeof(mFrame));
+        mFrame.cycle = Get(8);
+        mDictSize = 0;
+        mError = nullptr;
+        return (bool)mIn;
+    }
+
+    bool Next(TraceFrame& f)            // false at the end of the file or on an error
+    {
+        for (;;)
+        {
+            int mask = mIn.get();
+            if (mask == EOF || mError)
+            {
+                return false;
+            }
+            if (mask & 0x01)
+            {
+                int slot = mIn.get();
+                if (slot == 0xfe)       // resync
+                {
+                    DWORD control = mFrame.control;
+                    uint64_t cycle = Varint();
+                    memset(&mFrame, 0, sizeof(mFrame));
+                    mFrame.control = control;
+                    mFrame.cycle = cycle;
+                    continue;
+                }
+                if (slot == 0xff)
+                {
+                    mFrame.control = (DWORD)Get(4);
+                    if (mDictSize < TRACE_DICT_SIZE) mDict[mDictSize++] = mFrame.control;
+                }
+                else if (slot >= 0 && slot < mDictSize)
+                {
+                    mFrame.control = mDict[slot];
+                }
+                else
+                {
+                    mError = "bad control slot";
+                    return false;
+                }
+            }
+            WORD sc = (mFrame.regs[REG_SC] + 1) & 0x000f;
+            if (mask & 0x02) mFrame.bus = Delta(mFrame.bus);
+            if (mask & 0x04) mFrame.regs[REG_PC] = Delta(mFrame.regs[REG_PC]);
+            if (mask & 0x08) mFrame.regs[REG_MAR] = Delta(mFrame.regs[REG_MAR]);
+            if (mask & 0x10) mFrame.regs[REG_GPR] = Delta(mFrame.regs[REG_GPR]);
+            if (mask & 0x20) mFrame.regs[REG_ACC] = Delta(mFrame.regs[REG_ACC]);
+            if (mask & 0x40) mFrame.regs[REG_F] = (WORD)mIn.get();
+            if (mask & 0x80)
+            {
+                int b = mIn.get();
+                sc = (WORD)(b & 0x0f);
+                mFrame.regs[REG_OPR] = (WORD)((b >> 4) & 0x0f);
+            }
+            mFrame.regs[REG_SC] = sc;
+            mFrame.cycle++;
+            if (!mIn)
+            {
+                mError = "truncated record";
+                return false;
+            }
+            f = mFrame;
+            return true;
+        }
+    }
+
+    const char* Error()                 // nullptr after a clean end of file
+    {
+        return mError;
+    }
+};
+
+/*******************************************************************************************************************
+
+                            TRACE
+    ------------------------------------------------------------------
+     Level              Records
+    ------------------------------------------------------------------
+     TRACE_OFF          nothing (one predictable branch per clock)
+     TRACE_INSTRUCTION  one record per instruction boundary (fetch step 0 done, SC = 1)
+     TRACE_MICROSTEP    one record per clock: Seq Count, OpCode, Control Bus, registers
+     TRACE_BUS          as above plus the bus value and one record per memory write (GPR_M)
+    ------------------------------------------------------------------
+
+    Records are fixed-size and go into a ring buffer; nothing is formatted while the
+    machine is stepping. Dump() formats the retained records (the newest Capacity()).
+
+*******************************************************************************************************************/
+
+enum TraceLevel { TRACE_OFF = 0, TRACE_INSTRUCTION, TRACE_MICROSTEP, TRACE_BUS };
+
+struct TraceRecord                      // 32 bytes
+{
+    uint64_t cycle;
+    DWORD control;                      // control word of this clock
+    WORD bus;
+    WORD addr;                          // memory write records: address (MAR)
+    WORD regs[7];                       // SC, PC, MAR, OPR, GPR, Acc, F - same order as CoreState::reg
+    BYTE opcode;                        // opcode seen by Control
+    BYTE kind;                          // TRACE_INSTRUCTION, TRACE_MICROSTEP or TRACE_BUS (memory write)
+};
+
+class TraceBuffer
+{
+private:
+
+    std::vector<TraceRecord> mRing;
+    size_t mCapacity;
+    uint64_t mHead;                     // records pushed since Clear()
+    TraceLevel mLevel;
+    TraceWriter* mWriter;               // binary stream of every clock, independent of mLevel
+    bool mActive;                       // mLevel != TRACE_OFF or a writer attached
+
+public:
+
+    TraceBuffer(size_t capacity = 1 << 16)  // capacity is rounded up to a power of two
+    : mCapacity(1), mHead(0), mLevel(TRACE_OFF), mWriter(nullptr), mActive(false)
+    {
+        while (mCapacity < capacity) mCapacity <<= 1;
+    }
+
+    void SetLevel(TraceLevel level)     // the ring is only allocated once tracing is switched on
+    {
+        if (level != TRACE_OFF && mRing.size() < mCapacity)
+        {
+            mRing.resize(mCapacity);
+        }
+        mLevel = level;
+        mActive = (mLevel != TRACE_OFF || mWriter);
+    }
+
+    TraceLevel Level()
+    {
+        return mLevel;
+    }
+
+    void SetWriter(TraceWriter* writer) // nullptr detaches it; the caller owns and closes it
+    {
+        mWriter = writer;
+        mActive = (mLevel != TRACE_OFF || mWriter);
+    }
+
+    TraceWriter* Writer()
+    {
+        return mWriter;
+    }
+
+    bool Active()                       // Computer::Tick() calls Record() only when true
+    {
+        return mActive;
+    }
+
+    size_t Capacity()
+    {
+        return mCapacity;
+    }
+
+    void Clear()
+    {
+        mHead = 0;
+    }
+
+    void Push(const TraceRecord& r)
+    {
+        mRing[mHead & (mRing.size() - 1)] = r;
+        mHead++;
+    }
+
+    void Dump(std::ostream& os, bool changesOnly = false)   // changesOnly: microsteps list only the registers that changed
+    {
+        if (mRing.empty())
+        {
+            return;
+        }
+
+        uint64_t first = (mHead > mRing.size()) ? mHead - mRing.size() : 0;
+        const TraceRecord* prev = nullptr;  // previous microstep record
+
+        if (first)
+        {
+            os << "\n****** TRACE ****** " << first << " older records dropped\n";
+        }
+
+        for (uint64_t i = first; i < mHead; i++)
+        {
+            const TraceRecord& r = mRing[i & (mRing.size() - 1)];
+
+            if (r.kind == TRACE_INSTRUCTION)
+            {
+                os << "\n[" << r.cycle << "] OpCode " << (WORD)r.opcode << "  PC " << r.regs[1] << "  GPR " << r.regs[4]
+                   << "  Acc " << r.regs[5] << "  F " << (r.regs[6] & 0x0001) << "  Z " << ((r.regs[6] >> 1) & 0x0001) << "\n";
+            }
+            else if (r.kind == TRACE_BUS)
+            {
+                os << "\nM[" << r.addr << "] <- " << r.bus << "\n";
+            }
+            else
+            {
+                os << "\nSeq Count ->" << ((r.regs[0] - 1) & 0x000f) << "\n";  // SC has already counted past this step
+                os << "\nOpCode ->" << (WORD)r.opcode << "\n";
+                os << "\nControl Bus = " << r.control << "\n";
+                if (mLevel >= TRACE_BUS) os << "\nBus = " << r.bus << "\n";
+                for (int k = 0; k < 7; k++)
+                {
+                    if (!changesOnly) os << "\nReg -> " << r.regs[k] << "\n";
+                    else if (!prev || r.regs[k] != prev->regs[k]) os << "\nReg " << RegNames[k] << " -> " << r.regs[k] << "\n";
+                }
+                prev = &r;
+            }
+        }
+    }
+
+};
+
+
+/*******************************************************************************************************************
+
+                            STATIC PIPELINE
+    ------------------------------------------------------------------
+    Same components, same order as Computer::mComponents, but composed at compile time.
+    Each phase is a fold over the tuple that calls only the components whose Phases
+    member includes it, through a qualified (non-virtual) call the compiler can inline.
+    GprBus for instance is only visited on the falling edge and Control only on the
+    rising edge.
+
+*******************************************************************************************************************/
+
+template <typename... Parts>
+class StaticPipeline
+{
+private:
+
+    std::tuple<Parts*...> mParts;
+
+    template <BYTE Phase, typename T>
+    static void Call(T& c)
+    {
+        if constexpr ((T::Phases & Phase) == 0)
+        {
+        }
+        else if constexpr (Phase == PHASE_RISING)
+        {
+            c.T::RisingEdge();
+        }
+        else if constexpr (Phase == PHASE_HIGH)
+        {
+            c.T::HighLevel();
+        }
+        else if constexpr (Phase == PHASE_FALLING)
+        {
+            c.T::FallingEdge();
+        }
+        else
+        {
+            c.T::LowLevel();
+        }
+    }
+
+    template <BYTE Phase>
+    void Run()
+    {
+        std::apply([](auto&... p) { (Call<Phase>(*p), ...); }, mParts);
+    }
+
+public:
+
+    StaticPipeline() {}
+
+    StaticPipeline(Parts*... parts)
+    : mParts(parts...) {}
+
+    void Clock()
+    {
+        Run<PHASE_RISING>();
+        Run<PHASE_HIGH>();
+        Run<PHASE_FALLING>();
+        Run<PHASE_LOW>();
+    }
+};
+
+/*******************************************************************************************************************
+
+                            EVENT SCHEDULE
+    ------------------------------------------------------------------
+     component      Reacts(control)
+    ------------------------------------------------------------------
+     Register       high: control & out mask, falling: control & incr mask (SC always),
+                    low: control & in mask
+     GprBus         falling: control & PC_GPR/GPR_OP
+     Adder          high: ADD (the sum), falling: always (Z follows GPR)
+     Memory         high: M_GPR, low: GPR_M
+     Control        rising only
+    ------------------------------------------------------------------
+
+    SCHED_EVENT walks the same Component objects as SCHED_DYNAMIC, in the same order, but
+    only those that do something on this clock. The control word of a clock comes from
+    Control's dispatch entry. ControlClasses groups the Dispatch entries by control word
+    at compile time, and the Computer builds one set per distinct word: the rising edge
+    runs as usual, then Control::Index() picks the set for the other three phases. A component skipped in a
+    phase is one whose call would not have changed anything, so the result is that of
+    SCHED_DYNAMIC clock for clock. A typical microstep visits 6-8 components instead of
+    44 phase calls.
+
+*******************************************************************************************************************/
+
+#define COMPONENT_MAX   16
+#define CONTROL_WORDS_MAX   64          // distinct control words of Dispatch
+
+struct ControlClasses                   // Dispatch entries grouped by control word
+{
+    DWORD word[CONTROL_WORDS_MAX];
+    BYTE count;
+    BYTE of[sizeof(Dispatch.op) / sizeof(MicroOp)];     // index into word[] per dispatch index
+};
+
+constexpr ControlClasses BuildControlClasses()
+{
+    ControlClasses t = {};
+    for (size_t i = 0; i < sizeof(Dispatch.op) / sizeof(MicroOp); i++)
+    {
+        BYTE k = 0;
+        while (k < t.count && t.word[k] != Dispatch.op[i].control) k++;
+        if (k == t.count) t.word[t.count++] = Dispatch.op[i].control;
+        t.of[i] = k;
+    }
+    return t;
+}
+
+constexpr ControlClasses ControlClass = BuildControlClasses();
+static_assert(ControlClass.count < CONTROL_WORDS_MAX, "raise CONTROL_WORDS_MAX");
+
+struct ActiveSet                        // components to visit in the high, falling and low phases
+{
+    BYTE count[3];
+    Component* part[3][COMPONENT_MAX];
+};
+
+/*******************************************************************************************************************
+
+                            CLOCK SOURCES
+    ------------------------------------------------------------------
+     SteadyClock    PACE_SLEEP      std::chrono::steady_clock; WaitUntil() sleeps (coarse, least CPU)
+                    PACE_PRECISE    sleeps until PACE_SPIN_NS before the deadline, then yields in a loop
+     VirtualClock                   time only moves in WaitUntil(), which returns at once:
+                                    free-running, with the same time base a paced run would see
+    ------------------------------------------------------------------
+
+    Computer::Update() asks its clock source for the time and runs as many machine
+    clocks as the elapsed time is worth. The paced loop in main() calls Update() once
+    per PACE_SLICE_NS and then waits for the next slice boundary, so each call runs about
+    CLOCK_HZ * PACE_SLICE_NS / 1e9 clocks (1843 for 1 ms) instead of the ~28k-clock bursts
+    of a 15.6 ms tick.
+
+    The accounting is in integers: clock n of a paced run is due at origin + n * 1e9 / hz
+    ns, and Update() runs the clocks due by Now(), so nothing accumulates and a run of
+    any length stays exact to the clock.
+    ------------------------------------------------------------------
+     PaceStats      meaning
+    ------------------------------------------------------------------
+     hz             target frequency, CLOCK_HZ unless SetFrequency() was called
+     deadlineNs     a clock run later than this after it was due missed its deadline,
+                    PACE_DEADLINE_NS unless given to SetFrequency()
+     clocks, wallNs clocks run and wall time since the pacing origin (Reset(), SetClock(),
+                    SetFrequency(), RestoreSnapshot()) at the end of the last Update();
+                    once halted, the time the HLT clock was due plus the time the last
+                    Update() took, so a short run is not charged the rest of its slice
+     maxLagNs       worst delay of the oldest clock owed when an Update() started;
+                    about one slice while the host keeps up
+     missed         clocks run more than deadlineNs after they were due
+     lateUpdates    Update() calls that found at least one such clock
+    ------------------------------------------------------------------
+
+*******************************************************************************************************************/
+
+#define PACE_SLICE_NS   1000000         // one Update() per ms
+#define PACE_SPIN_NS    200000          // PACE_PRECISE: stop sleeping this long before the deadline
+#define PACE_DEADLINE_NS (2 * PACE_SLICE_NS)    // a clock later than this missed its deadline
+#define NS_PER_S        1000000000ull
+
+enum Pacing { PACE_SLEEP = 0, PACE_PRECISE };
+
+struct PaceStats                        // Computer::Pacing()
+{
+    uint64_t hz;
+    uint64_t deadlineNs;
+    uint64_t clocks;
+    uint64_t wallNs;
+    uint64_t maxLagNs;
+    uint64_t missed;
+    uint64_t updates;
+    uint64_t lateUpdates;
+
+    double Achieved() const             // clocks per wall second
+    {
+        return wallNs ? clocks * 1e9 / wallNs : 0.0;
+    }
+
+    void Display(std::ostream& os) const
+    {
+        os << "\n****** PACING ******\n";
+        os << "target       : " << hz << " Hz\n";
+        os << "achieved     : " << Achieved() << " Hz (" << (hz && wallNs ? (Achieved() / hz - 1.0) * 1e6 : 0.0) << " ppm)\n";
+        os << "max lag      : " << maxLagNs / 1e3 << " us\n";
+        os << "missed       : " << missed << " clocks in " << lateUpdates << " of " << updates << " updates"
+           << " (deadline " << deadlineNs / 1e3 << " us)\n";
+    }
+};
+
+class ClockSource
+{
+public:
+
+    virtual ~ClockSource() {}
+    virtual uint64_t Now() = 0;                 // ns since an arbitrary origin
+    virtual void WaitUntil(uint64_t t) = 0;     // returns once Now() >= t
+};
+
+class SteadyClock : public ClockSource
+{
+private:
+
+    std::chrono::steady_clock::time_point mOrigin;
+    Pacing mPacing;
+
+public:
+
+    SteadyClock(Pacing pacing = PACE_PRECISE)
+    : mOrigin(std::chrono::steady_clock::now()), mPacing(pacing)
+    {
+    }
+
+    void SetPacing(Pacing pacing)
+    {
+        mPacing = pacing;
+    }
+
+    uint64_t Now()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - mOrigin).count();
+    }
+
+    void WaitUntil(uint64_t t)
+    {
+        uint64_t now = Now();
+        if (now >= t)
+        {
+            return;
+        }
+        if (mPacing == PACE_SLEEP)
+        {
+            std::this_thread::sleep_for(std::chrono::nanoseconds(t - now));
+            return;
+        }
+        if (t - now > PACE_SPIN_NS)
+        {
+            std::this_thread::sleep_for(std::chrono::nanoseconds(t - now - PACE_SPIN_NS));
+        }
+        while (Now() < t)
+        {
+            std::this_thread::yield();
+        }
+    }
+};
+
+class VirtualClock : public ClockSource
+{
+private:
+
+    uint64_t mNow;
+
+public:
+
+    VirtualClock() : mNow(0)
+    {
+    }
+
+    uint64_t Now()
+    {
+        return mNow;
+    }
+
+    void WaitUntil(uint64_t t)
+    {
+        if (t > mNow) mNow = t;
+    }
+
+    void Advance(uint64_t ns)
+    {
+        mNow += ns;
+    }
+};
+
+enum Schedule { SCHED_DYNAMIC = 0, SCHED_STATIC, SCHED_EVENT };   // how Computer::Step() walks the components
+
+enum RunStatus                          // returned by the Update()/Run() loops
+{
+    RUN_PAUSED = 0,                     // time slice or cycle budget used up; calling again resumes
+    RUN_HALTED,                         // HLT executed; Reset() or Reload() before running again
+    RUN_BREAK                           // a breakpoint or watchpoint hit, see Computer::LastBreak(); calling again resumes
+};
+
+/*******************************************************************************************************************
+
+                            BREAKPOINTS
+    ------------------------------------------------------------------
+     kind           set with                hits after the clock that
+    ------------------------------------------------------------------
+     BREAK_PC       SetPc(addr)             starts the fetch at PC = addr (SC = 1 after it),
+                                            i.e. before the instruction at addr executes
+     BREAK_READ     SetWatch(addr, r, w)    reads addr: M_GPR with MAR = addr
+     BREAK_WRITE    SetWatch(addr, r, w)    writes addr: GPR_M with MAR = addr
+     BREAK_REG      AddCondition(reg, v)    starts a fetch with register reg = v while it
+                                            was not at the previous instruction boundary
+    ------------------------------------------------------------------
+
+    The addresses are bitmaps over the largest geometry, so a check is a few shifts no
+    matter how many are set. Computer::Run() picks between two instances of its clock
+    loop: without anything set the loop has no check at all, with something set it calls
+    Check() after every clock. Update() tests Any() once per clock, one branch that is
+    always predicted. The instruction engines (FastCpu, LaneCpu) do not stop at
+    breakpoints.
+
+*******************************************************************************************************************/
+
+#define BREAK_WORDS         ((1 << ADDR_BITS_MAX) / 64)
+
+enum BreakKind { BREAK_NONE = 0, BREAK_PC, BREAK_READ, BREAK_WRITE, BREAK_REG };
+
+struct BreakHit
+{
+    BreakKind kind;
+    uint64_t cycle;                     // clocks since Reset() when it hit
+    WORD addr;                          // PC for BREAK_PC and BREAK_REG, MAR for the watchpoints
+    BYTE reg;                           // BREAK_REG: RegIndex and the value it reached
+    WORD value;
+};
+
+class Breakpoints
+{
+private:
+    struct Condition
+    {
+        BYTE reg;
+        WORD value;
+        bool met;                       // at the previous instruction boundary
+    };
+
+    uint64_t mPc[BREAK_WORDS];
+    uint64_t mRead[BREAK_WORDS];
+    uint64_t mWrite[BREAK_WORDS];
+    std::vector<Condition> mConditions;
+    bool mAny;
+
+    static bool Test(const uint64_t* set, WORD addr)
+    {
+        return (set[(addr >> 6) % BREAK_WORDS] >> (addr & 63)) & 1;
+    }
+
+    static void Mark(uint64_t* set, WORD addr, bool on)
+    {
+        uint64_t bit = 1ull << (addr & 63);
+        set[(addr >> 6) % BREAK_WORDS] = on ? (set[(addr >> 6) % BREAK_WORDS] | bit) : (set[(addr >> 6) % BREAK_WORDS] & ~bit);
+    }
+
+    void Update()
+    {
+        mAny = !mConditions.empty();
+        for (int i = 0; i < BREAK_WORDS && !mAny; i++)
+        {
+            mAny = (mPc[i] | mRead[i] | mWrite[i]) != 0;
+        }
+    }
+
+public:
+    Breakpoints()
+    {
+        Clear();
+    }
+
+    void Clear()
+    {
+        memset(mPc, 0, sizeof(mPc));
+        memset(mRead, 0, sizeof(mRead));
+        memset(mWrite, 0, sizeof(mWrite));
+        mConditions.clear();
+        mAny = false;
+    }
+
+    void SetPc(WORD addr, bool on = true)
+    {
+        Mark(mPc, addr, on);
+        Update();
+    }
+
+    void SetWatch(WORD addr, bool read, bool write)     // both false removes the watchpoint
+    {
+        Mark(mRead, addr, read);
+        Mark(mWrite, addr, write);
+        Update();
+    }
+
+    void AddCondition(BYTE reg, WORD value)
+    {
+        mConditions.push_back({ (BYTE)(reg % REG_COUNT), value, false });
+        Update();
+    }
+
+    bool Any() const
+    {
+        return mAny;
+    }
+
+    void Rearm()                        // Computer::Reset(): the conditions start out as not met
+    {
+        for (Condition& c : mConditions) c.met = false;
+    }
+
+    bool Check(const CoreState& s, uint64_t cycle, BreakHit& hit)   // after a clock; true and hit filled in if it hits
+    {
+        DWORD control = s.control;
+        WORD mar = s.reg[REG_MAR];
+        bool boundary = (s.reg[REG_SC] == 1);   // the first fetch clock, the previous instruction is complete
+        bool any = false;
+
+        hit.kind = BREAK_NONE;
+        hit.cycle = cycle;
+        hit.addr = 0;
+        hit.reg = 0;
+        hit.value = 0;
+        if ((control & M_GPR) && Test(mRead, mar))
+        {
+            hit.kind = BREAK_READ;
+            hit.addr = mar;
+        }
+        else if ((control & GPR_M) && Test(mWrite, mar))
+        {
+            hit.kind = BREAK_WRITE;
+            hit.addr = mar;
+        }
+        else if (boundary && Test(mPc, s.reg[REG_PC]))
+        {
+            hit.kind = BREAK_PC;
+            hit.addr = s.reg[REG_PC];
+        }
+        any = (hit.kind != BREAK_NONE);
+
+        if (boundary)                   // every condition keeps its edge state, also when something else hit
+        {
+            for (Condition& c : mConditions)
+            {
+                bool met = (s.reg[c.reg] == c.value);
+                if (met && !c.met && !any)
+                {
+                    hit.kind = BREAK_REG;
+                    hit.addr = s.reg[REG_PC];
+                    hit.reg = c.reg;
+                    hit.value = c.value;
+                    any = true;
+                }
+                c.met = met;
+            }
+        }
+        return any;
+    }
+};
+
+/*******************************************************************************************************************
+
+                            SNAPSHOTS
+    ------------------------------------------------------------------
+     field          file (little-endian)
+    ------------------------------------------------------------------
+     magic          DWORD   SNAPSHOT_MAGIC ("TSNP")
+     version        DWORD   SNAPSHOT_VERSION; Load() refuses other versions
+     addrBits       BYTE    Geometry it was taken on; RestoreSnapshot() refuses others
+     cycles         uint64  clocks since Reset()
+     core           7 x WORD registers, WORD bus, DWORD control word, BYTE opcode,
+                    BYTE halted, PAGE_WORDS x WORD memory page 0
+     counters       PerfCounters, one uint64 per field
+     pages          WORD count, then per page: WORD page number, PAGE_WORDS x WORD
+    ------------------------------------------------------------------
+
+    A snapshot is taken between clocks and holds everything Step() depends on, so a
+    restored machine continues clock for clock as if it had never stopped. Only the
+    pages above 0 that are in use are kept; in the default geometry a snapshot is one
+    CoreState plus the counters and restoring is two copies.
+
+    Computer::SetCheckpoints(every, keep) also snapshots the machine every 'every'
+    clocks into a ring of the last 'keep' checkpoints. Seek(cycle) restores the newest
+    checkpoint at or before cycle (the loaded image if there is none) and runs forward
+    from there, so a late state is reached without replaying from reset. Checkpoints
+    taken after the point Seek() or RestoreSnapshot() went back to are dropped, the run
+    may take another path from there.
+
+*******************************************************************************************************************/
+
+#define SNAPSHOT_MAGIC      0x504e5354  // "TSNP"
+#define SNAPSHOT_VERSION    1
+#define CHECKPOINT_KEEP     64          // default ring size of SetCheckpoints()
+
+struct Snapshot
+{
+    DWORD version;
+    BYTE addrBits;
+    uint64_t cycles;
+    CoreState core;
+    PerfCounters counters;
+    std::vector<WORD> pages;            // numbers of the pages above 0 in use
+    std::vector<WORD> pageData;         // PAGE_WORDS words per entry of pages
+
+    static void Put(std::ostream& out, uint64_t v, int bytes)
+    {
+        for (int i = 0; i < bytes; i++)
+        {
+            out.put((char)((v >> (8 * i)) & 0xff));
+        }
+    }
+
+    static uint64_t Get(std::istream& in, int bytes)
+    {
+        uint64_t v = 0;
+        for (int i = 0; i < bytes; i++)
+        {
+            v |= (uint64_t)(BYTE)in.get() << (8 * i);
+        }
+        return v;
+    }
+
+    bool Save(const char* path) const
+    {
+        std::ofstream out(path, std::ios::binary);
+        const uint64_t* c = (const uint64_t*)&counters;
+
+        Put(out, SNAPSHOT_MAGIC, 4);
+        Put(out, version, 4);
+        Put(out, addrBits, 1);
+        Put(out, cycles, 8);
+        for (WORD r : core.reg) Put(out, r, 2);
+        Put(out, core.bus, 2);
+        Put(out, core.control, 4);
+        Put(out, core.opcode, 1);
+        Put(out, core.halted, 1);
+        for (WORD w : core.mem) Put(out, w, 2);
+        for (size_t i = 0; i < sizeof(counters) / sizeof(uint64_t); i++) Put(out, c[i], 8);
+        Put(out, pages.size(), 2);
+        for (size_t p = 0; p < pages.size(); p++)
+        {
+            Put(out, pages[p], 2);
+            for (int i = 0; i < PAGE_WORDS; i++) Put(out, pageData[p * PAGE_WORDS + i], 2);
+        }
+        return (bool)out;
+    }
+
+    bool Load(const char* path)
+    {
+        std::ifstream in(path, std::ios::binary);
+        uint64_t* c = (uint64_t*)&counters;
+
+        if (Get(in, 4) != SNAPSHOT_MAGIC || Get(in, 4) != SNAPSHOT_VERSION || !in)
+        {
+            return false;
+        }
+        version = SNAPSHOT_VERSION;
+        addrBits = (BYTE)Get(in, 1);
+        cycles = Get(in, 8);
+        memset(&core, 0, sizeof(core));
+        for (WORD& r : core.reg) r = (WORD)Get(in, 2);
+        core.bus = (WORD)Get(in, 2);
+        core.control = (DWORD)Get(in, 4);
+        core.opcode = (BYTE)Get(in, 1);
+        core.halted = (BYTE)Get(in, 1);
+        for (WORD& w : core.mem) w = (WORD)Get(in, 2);
+        for (size_t i = 0; i < sizeof(counters) / sizeof(uint64_t); i++) c[i] = Get(in, 8);
+        pages.resize((size_t)Get(in, 2));
+        pageData.resize(pages.size() * PAGE_WORDS);
+        for (size_t p = 0; p < pages.size(); p++)
+        {
+            pages[p] = (WORD)Get(in, 2);
+            for (int i = 0; i < PAGE_WORDS; i++) pageData[p * PAGE_WORDS + i] = (WORD)Get(in, 2);
+        }
+        return (bool)in && in.peek() == EOF;
+    }
+};
+
+/*******************************************************************************************************************
+
+                            VARIANTS
+    ------------------------------------------------------------------
+     variant    was                                           A_GPR (STA step 2)             program
+    ------------------------------------------------------------------
+     cpu5       improved_simple_computer_control_cpu_5.cpp    the Adder copies Acc to GPR    dbl-sum
+     cpu2       improved_simple_computer_control_cpu_2.cpp    Acc drives the bus, GPR        add-list
+                                                              latches it
+    ------------------------------------------------------------------
+
+    The two source files used to be one machine each, copied and edited: the same
+    components wired with different line masks and a different prg[]. Both are now
+    rows of Variants[]: Computer(g, VARIANT_CPU2) builds the cpu_2 wiring with its
+    program loaded. The registers, memory and flags match clock for clock. Only the
+    data bus differs, in the A_GPR clock of STA, where cpu2 shows Acc on it. Any
+    program runs on either variant (LoadProgram(), --program).
+
+*******************************************************************************************************************/
+
+enum MachineVariant { VARIANT_CPU5 = 0, VARIANT_CPU2, VARIANT_COUNT };
+
+struct VariantInfo
+{
+    const char* name;
+    const char* program;                // ReferencePrograms[] entry loaded by the constructor
+    DWORD accOut;                       // lines on which Acc drives the bus
+    DWORD gprIn;                        // lines on which GPR latches the bus
+    DWORD aluIn;                        // lines the Adder acts on
+};
+
+const VariantInfo Variants[VARIANT_COUNT] =
+{
+    { "cpu5", "dbl-sum",  0,     PC_GPR | M_GPR,         ALU_LINES },
+    { "cpu2", "add-list", A_GPR, PC_GPR | A_GPR | M_GPR, ALU_LINES & ~A_GPR },
+};
+
+inline bool ParseVariant(const char* s, MachineVariant& v)
+{
+    for (int i = 0; i < VARIANT_COUNT; i++)
+    {
+        if (strcmp(s, Variants[i].name) == 0)
+        {
+            v = (MachineVariant)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+/*******************************************************************************************************************
+
+                            EMBEDDING
+    ------------------------------------------------------------------
+     call                               does
+    ------------------------------------------------------------------
+     Computer cpu(Geometry(bits))       builds the machine with the default program loaded
+     Computer cpu(g, VARIANT_CPU2)      the cpu_2 wiring and program, see VARIANTS
+     cpu.Load(words, n)                 new memory image and Reset(); false if n > memory
+     cpu.Run(maxCycles)                 RUN_HALTED, RUN_PAUSED (budget used) or RUN_BREAK
+     cpu.Step()                         one clock
+     cpu.ReadRegs(regs)                 REG_COUNT words: SC, PC, MAR, OPR, GPR, Acc, F
+     cpu.ReadMem(first, count, words)   a range of memory, any Geometry
+     cpu.Reload() / cpu.Reset()         run the same image again / keep memory as it is
+     cpu.AttachIo(&window)              result FIFO, input queue and timer at the top of memory
+    ------------------------------------------------------------------
+
+    Everything in this header can be included by another program: nothing prints unless
+    a Display...() function is called with a stream, nothing exits, and there is no
+    global state, so any number of Computers can live side by side, one per thread.
+    The taub executable (improved_simple_computer_control_cpu_5.cpp) is one such program.
+    Its allocation counter for --bench replaces operator new, so it is not part of the
+    header.
+
+*******************************************************************************************************************/
+
+class Computer
+{
+protected:
+	ClockSource* mClock;                // time base of Update(), mSteadyClock unless SetClock() was called
+	SteadyClock mSteadyClock;
+	uint64_t mPaceOrigin;               // mClock->Now() when paced clock mPaceBase was current
+	uint64_t mPaceBase;                 // mCycles at mPaceOrigin
+	PaceStats mPace;
+	std::vector<uint64_t> mProfile;     // instructions fetched per address, empty = profiling off
+	uint64_t mCycles;                   // clocks executed since Reset()
+    Geometry mGeometry;
+    MachineVariant mVariant;
+    CoreState mState;                   // registers, lines and memory page 0; the components below are views of it
+    Register mSc, mPc, mMar, mOpr, mGpr, mAcc, mFlg;
+    GprBus mGBus;
+    Adder mAlu;
+    Memory mRam;
+    Control mCtrl;
+    std::vector<Component*> mComponents;
+    TraceBuffer mTrace;
+    StaticPipeline<Register, Register, Register, Register, Register, Register, Register, GprBus, Adder, Memory, Control> mPipeline;
+    Schedule mSchedule;
+    std::vector<Component*> mRising;    // SCHED_EVENT: the rising edge, then mActiveSets[ControlClass.of[Control::Index()]]
+    std::vector<ActiveSet> mActiveSets;
+    std::vector<Snapshot> mCheckpoints; // ring of automatic checkpoints, oldest at mCheckpointFirst
+    size_t mCheckpointFirst, mCheckpointCount;
+    uint64_t mCheckpointEvery;          // 0 = off
+    uint64_t mNextCheckpoint;           // cycle of the next automatic checkpoint, UINT64_MAX when off
+    WORD mSeen[REG_COUNT];              // registers as of the last DisplayChanges() or Reset()
+    std::vector<WORD> mChanged;         // scratch for Memory::TakeChanges()
+    Breakpoints mBreaks;
+    BreakHit mHit;                      // the last RUN_BREAK
+
+    const Snapshot& CheckpointAt(size_t i)      // 0 = oldest
+    {
+        return mCheckpoints[(mCheckpointFirst + i) % mCheckpoints.size()];
+    }
+
+    NOINLINE void Checkpoint()          // from Step(), every mCheckpointEvery clocks; kept out of the clock loop
+    {
+        size_t keep = mCheckpoints.size();
+        SaveSnapshot(mCheckpoints[(mCheckpointFirst + mCheckpointCount) % keep]);
+        if (mCheckpointCount < keep) mCheckpointCount++;
+        else mCheckpointFirst = (mCheckpointFirst + 1) % keep;
+        mNextCheckpoint += mCheckpointEvery;
+    }
+
+    void Rewound()                      // after going back to mCycles: later checkpoints no longer belong to this run
+    {
+        while (mCheckpointCount && CheckpointAt(mCheckpointCount - 1).cycles > mCycles)
+        {
+            mCheckpointCount--;
+        }
+        mNextCheckpoint = mCheckpointEvery ? (mCycles / mCheckpointEvery + 1) * mCheckpointEvery : UINT64_MAX;
+    }
+
+    void BuildActivity()                // SCHED_EVENT: the components every phase visits, per distinct control word
+    {
+        const BYTE phases[3] = { PHASE_HIGH, PHASE_FALLING, PHASE_LOW };
+
+        mRising.clear();
+        for (Component* c : mComponents)
+        {
+            if (c->Reacts(0) & PHASE_RISING) mRising.push_back(c);
+        }
+        mActiveSets.assign(ControlClass.count, ActiveSet());
+        for (size_t k = 0; k < ControlClass.count; k++)
+        {
+            ActiveSet& a = mActiveSets[k];
+            for (Component* c : mComponents)    // component order within every phase
+            {
+                BYTE reacts = c->Reacts(ControlClass.word[k]);
+                for (int p = 0; p < 3; p++)
+                {
+                    if (reacts & phases[p]) a.part[p][a.count[p]++] = c;
+                }
+            }
+        }
+    }
+
+    template<bool Debug>                // Debug = false: the clock loop without breakpoint checks
+    RunStatus RunLoop(uint64_t maxCycles)
+    {
+		while (!mCtrl.Halted() && maxCycles)    // in runs up to the next checkpoint, mNextCheckpoint > mCycles
+		{
+		    uint64_t start = mCycles;
+		    uint64_t end = mCycles + std::min(maxCycles, mNextCheckpoint - mCycles);
+		    bool hit = false;
+		    while (!mCtrl.Halted() && mCycles < end)
+		    {
+			    Tick();
+			    if (Debug && mBreaks.Check(mState, mCycles, mHit))
+			    {
+			        hit = true;
+			        break;
+			    }
+		    }
+		    maxCycles -= mCycles - start;
+		    if (mCycles == mNextCheckpoint) Checkpoint();
+		    if (Debug && hit) return RUN_BREAK;
+		}
+		return mCtrl.Halted() ? RUN_HALTED : RUN_PAUSED;
+    }
+
+    void Record()                       // called after a clock when tracing or a trace stream is on
+    {
+        TraceRecord r;
+        WORD sc = mState.reg[REG_SC];
+
+        if (mTrace.Writer())
+        {
+            mTrace.Writer()->Push(mState);
+        }
+        if (mTrace.Level() == TRACE_OFF || (mTrace.Level() == TRACE_INSTRUCTION && sc != 1))
+        {
+            return;
+        }
+
+        r.cycle = mCycles;
+        r.control = mState.control;
+        r.bus = mState.bus;
+        r.addr = 0;
+        memcpy(r.regs, mState.reg, sizeof(r.regs));
+        r.opcode = mState.opcode;
+        r.kind = (mTrace.Level() == TRACE_INSTRUCTION) ? TRACE_INSTRUCTION : TRACE_MICROSTEP;
+        mTrace.Push(r);
+
+        if (mTrace.Level() >= TRACE_BUS && (mState.control & GPR_M))
+        {
+            r.kind = TRACE_BUS;
+            r.addr = r.regs[2];
+            mTrace.Push(r);
+        }
+    }
+
+public:
+	Computer(const Computer&) = delete;     // the components are bound to this object's mState
+	Computer& operator=(const Computer&) = delete;
+
+	Computer(const Geometry& g = Geometry(), MachineVariant v = VARIANT_CPU5)
+	: mGeometry(g),
+	  mVariant(v),
+	  mState(),
+	  mSc(mState, REG_SC, 0, 0, 0xffff, 0x000f),         // always counting
+	  mPc(mState, REG_PC, GPR_PC, BUS_FROM_PC, INCPC, g.addrMask),
+	  mMar(mState, REG_MAR, (PC_MAR | GPR_MAR), 0, 0, g.addrMask),
+	  mOpr(mState, REG_OPR, 0, 0, 0, 0x000f),
+	  mGpr(mState, REG_GPR, Variants[v].gprIn, BUS_FROM_GPR, INCGPR, g.dataMask),
+	  mAcc(mState, REG_ACC, 0, Variants[v].accOut, INCA, g.dataMask),
+	  mFlg(mState, REG_F, 0, 0, 0, 0x0003),
+	  mGBus(mState, g, GBUS_LINES, 0),
+	  mAlu(mState, g, Variants[v].aluIn, 0),
+	  mRam(mState, g, GPR_M, BUS_FROM_MEM),
+	  mCtrl(mState)
+	{
+        mClock = &mSteadyClock;
+        mPace.hz = CLOCK_HZ;
+        mPace.deadlineNs = PACE_DEADLINE_NS;
+
+        // 0b[HLT][CLRSC][INCPCZ][INCPCF]0000000000[INCA][COMA][COMF][CLRF][ROL][ROR][CLRA][ADD][INCGPR][PC_GPR][A_GPR][M_GPR][GPR_OP][GPR_MAR][PC_MAR][GPR_PC][INCPC][GPR_M]
+
+        mComponents = { &mSc, &mPc, &mAcc, &mGpr, &mFlg, &mOpr, &mMar, &mGBus, &mAlu, &mRam, &mCtrl };
+        mPipeline = { &mSc, &mPc, &mAcc, &mGpr, &mFlg, &mOpr, &mMar, &mGBus, &mAlu, &mRam, &mCtrl };
+        mSchedule = SCHED_DYNAMIC;
+        BuildActivity();
+        mCheckpoints.resize(1);
+        mCheckpointEvery = 0;
+        const ReferenceProgram* p = FindProgram(Variants[v].program);
+        if (p->image != DefaultProgram) mRam.Load(p->image, p->size);   // Memory starts out with DefaultProgram
+
+		Reset();
+
+	}
+
+	void Reset()                        // warm reset: registers, lines and counters; memory is kept
+	{
+		for (auto& c : mComponents) c->Reset();
+		mState.bus = 0;
+		mState.control = 0;
+		mCycles = 0;
+		mTrace.Clear();
+		if (mTrace.Writer()) mTrace.Writer()->Resync(0);
+		RestartPacing();
+		mCheckpointFirst = mCheckpointCount = 0;
+		Rewound();
+		if (!mProfile.empty())
+		{
+		    std::fill(mProfile.begin(), mProfile.end(), 0);
+		    mProfile[mState.reg[REG_PC]]++;     // the first instruction is fetched without a CLRSC
+		}
+		memcpy(mSeen, mState.reg, sizeof(mSeen));
+		mBreaks.Rearm();
+		mHit.kind = BREAK_NONE;
+		if (mRam.Io()) mRam.Io()->Restart();
+	}
+
+	void Reload()                       // Reset() plus the memory image of the last LoadProgram()
+	{
+	    mRam.Reload();
+	    Reset();
+	}
+
+	void Start(WORD pc)                 // Reset(), then the first fetch is from pc instead of 0
+	{
+	    Reset();
+	    mState.reg[REG_PC] = pc & mGeometry.addrMask;
+	    memcpy(mSeen, mState.reg, sizeof(mSeen));
+	    if (!mProfile.empty())
+	    {
+	        std::fill(mProfile.begin(), mProfile.end(), 0);
+	        mProfile[mState.reg[REG_PC]]++;
+	    }
+	}
+
+	void Step()                         // one clock cycle, then the automatic checkpoint if one is due
+	{
+	    Tick();
+        if (mCycles == mNextCheckpoint)
+        {
+            Checkpoint();
+        }
+	}
+
+	void Tick()                         // one clock cycle: the four phases over all components
+	{
+	    if (mSchedule == SCHED_STATIC)
+	    {
+	        mPipeline.Clock();
+	    }
+	    else if (mSchedule == SCHED_EVENT)
+	    {
+	        for (Component* c : mRising) c->RisingEdge();
+	        const ActiveSet& a = mActiveSets[ControlClass.of[mCtrl.Index()]];
+	        for (int i = 0; i < a.count[0]; i++) a.part[0][i]->HighLevel();
+	        for (int i = 0; i < a.count[1]; i++) a.part[1][i]->FallingEdge();
+	        for (int i = 0; i < a.count[2]; i++) a.part[2][i]->LowLevel();
+	    }
+	    else
+	    {
+		    for(auto& c : mComponents) c->RisingEdge();
+            for(auto& c : mComponents) c->HighLevel();
+            for(auto& c : mComponents) c->FallingEdge();
+            for(auto& c : mComponents) c->LowLevel();
+	    }
+        mCycles++;
+
+        if (mTrace.Active())
+        {
+            Record();
+        }
+	}
+
+	uint64_t ClocksBy(uint64_t ns)      // paced clocks due ns after the origin, exact for any run length
+	{
+	    return ns / NS_PER_S * mPace.hz + ns % NS_PER_S * mPace.hz / NS_PER_S;
+	}
+
+	uint64_t DueAt(uint64_t clocks)     // ns after the origin at which paced clock 'clocks' is due
+	{
+	    return clocks / mPace.hz * NS_PER_S + clocks % mPace.hz * NS_PER_S / mPace.hz;
+	}
+
+	void RestartPacing()                // the next Update() counts from here, statistics cleared
+	{
+	    uint64_t hz = mPace.hz;
+	    uint64_t deadline = mPace.deadlineNs;
+	    memset(&mPace, 0, sizeof(mPace));
+	    mPace.hz = hz;
+	    mPace.deadlineNs = deadline;
+	    mPaceOrigin = mClock->Now();
+	    mPaceBase = mCycles;
+	}
+
+	RunStatus Update()                  // real-time: runs the clocks due by the clock source's Now()
+	{
+		uint64_t start = mClock->Now();
+		uint64_t elapsed = start - mPaceOrigin;
+		uint64_t done = mCycles - mPaceBase;
+		uint64_t due = ClocksBy(elapsed);
+
+		if (mCtrl.Halted())
+		{
+		    return RUN_HALTED;
+		}
+		mPace.updates++;
+		if (due > done)
+		{
+		    uint64_t lag = elapsed - DueAt(done + 1);
+		    uint64_t late = (elapsed > mPace.deadlineNs) ? ClocksBy(elapsed - mPace.deadlineNs) : 0;
+		    if (lag > mPace.maxLagNs) mPace.maxLagNs = lag;
+		    if (late > done)
+		    {
+		        mPace.missed += late - done;
+		        mPace.lateUpdates++;
+		    }
+		}
+		while (mCycles - mPaceBase < due && !mCtrl.Halted())
+		{
+			Step();
+			mPace.clocks++;
+			if (mBreaks.Any() && mBreaks.Check(mState, mCycles, mHit))
+			{
+			    mPace.wallNs = mClock->Now() - mPaceOrigin;
+			    return RUN_BREAK;       // the clocks still due run in the next call
+			}
+		}
+		if (mCtrl.Halted())
+		{
+		    mPace.wallNs = DueAt(mCycles - mPaceBase) + (mClock->Now() - start);
+		    if (mRam.Io()) mRam.Io()->Flush();
+		    return RUN_HALTED;
+		}
+		mPace.wallNs = mClock->Now() - mPaceOrigin;
+		return RUN_PAUSED;
+	}
+
+	void SetFrequency(uint64_t hz, uint64_t deadlineNs = PACE_DEADLINE_NS)   // target of Update(), restarts the pacing
+	{
+	    mPace.hz = hz ? hz : CLOCK_HZ;
+	    mPace.deadlineNs = deadlineNs;
+	    RestartPacing();
+	}
+
+	const PaceStats& Pacing()
+	{
+	    return mPace;
+	}
+
+	void SetProfiling(bool on)          // counts the instructions fetched at every address; call before Reset()
+	{
+	    mProfile.assign(on ? mGeometry.words : 0, 0);
+	    mCtrl.SetProfile(on ? mProfile.data() : nullptr);
+	}
+
+	const std::vector<uint64_t>& Profile()
+	{
+	    return mProfile;
+	}
+
+	RunStatus Run(uint64_t maxCycles)   // free-running: no pacing, steps until HLT, a breakpoint or until maxCycles more clocks have run
+	{
+	    RunStatus status = mBreaks.Any() ? RunLoop<true>(maxCycles) : RunLoop<false>(maxCycles);
+	    if (status == RUN_HALTED && mRam.Io()) mRam.Io()->Flush();     // the partial last block of results
+	    return status;
+	}
+
+	void AttachIo(IoWindow* io)         // maps the I/O window onto the top of memory; nullptr detaches it
+	{
+	    mRam.Attach(io);
+	    if (io) io->Bind(&mCycles, mGeometry);
+	}
+
+	Breakpoints& Breaks()
+	{
+	    return mBreaks;
+	}
+
+	const BreakHit& LastBreak()
+	{
+	    return mHit;
+	}
+
+	void DisplayBreak(std::ostream& os)     // the last RUN_BREAK and the registers at that point
+	{
+	    os << "\n****** BREAK ****** clock " << mHit.cycle << ", ";
+	    switch (mHit.kind)
+	    {
+	    case BREAK_PC:    os << "PC = " << mHit.addr; break;
+	    case BREAK_READ:  os << "read M[" << mHit.addr << "] = " << mRam.Read(mHit.addr); break;
+	    case BREAK_WRITE: os << "write M[" << mHit.addr << "] = " << mRam.Read(mHit.addr); break;
+	    case BREAK_REG:   os << RegNames[mHit.reg] << " = " << mHit.value << " at PC " << mHit.addr; break;
+	    default:          os << "none"; break;
+	    }
+	    os << "\n";
+	    for (int r = 0; r < REG_COUNT; r++)
+	    {
+	        os << RegNames[r] << " " << mState.reg[r] << ((r + 1 < REG_COUNT) ? "  " : "\n");
+	    }
+	}
+
+	bool Halted()
+	{
+		return mCtrl.Halted();
+	}
+
+	uint64_t Cycles()
+	{
+		return mCycles;
+	}
+
+	void DisplayRegs(std::ostream& os = std::cout)
+	{
+	    for(WORD r : mState.reg)
+        {
+            os << "\nReg -> " << r << "\n";
+        }
+	}
+
+	void DisplayMemory(std::ostream& os = std::cout)
+	{
+	    mRam.DisplayMemory(os);
+	}
+
+	bool DisplayChanges(std::ostream& os)   // registers and memory words changed since the last call or Reset(); false if none
+	{
+	    if (mRam.TakeChanges(mChanged) == 0 && memcmp(mSeen, mState.reg, sizeof(mSeen)) == 0)
+	    {
+	        return false;
+	    }
+	    os << "\n****** CHANGES ****** clock " << mCycles << "\n";
+	    for (int r = 0; r < REG_COUNT; r++)
+	    {
+	        if (mState.reg[r] != mSeen[r]) os << RegNames[r] << " " << mSeen[r] << " -> " << mState.reg[r] << "\n";
+	    }
+	    for (WORD a : mChanged)
+	    {
+	        os << "M[" << a << "] = " << mRam.Read(a) << "\n";
+	    }
+	    memcpy(mSeen, mState.reg, sizeof(mSeen));
+	    return true;
+	}
+
+	TraceBuffer& Trace()
+	{
+	    return mTrace;
+	}
+
+	PerfCounters Counters()             // snapshot
+	{
+	    return mCtrl.Counters();
+	}
+
+	Memory& Ram()
+	{
+	    return mRam;
+	}
+
+	void SetSchedule(Schedule s)
+	{
+	    mSchedule = s;
+	}
+
+	void SetClock(ClockSource* clock)   // time base of Update(); nullptr = the built-in SteadyClock
+	{
+	    mClock = clock ? clock : &mSteadyClock;
+	    RestartPacing();
+	}
+
+	ClockSource& Clock()
+	{
+	    return *mClock;
+	}
+
+	const Geometry& Layout()
+	{
+	    return mGeometry;
+	}
+
+	MachineVariant Variant()
+	{
+	    return mVariant;
+	}
+
+	void LoadProgram(const WORD* image, WORD n)     // new image; call Reset() before running it
+	{
+	    mRam.Load(image, n);
+	}
+
+	bool LoadProgram(ProgramImage& image)   // false (nothing loaded) if the image was built for another address width
+	{
+	    if (image.Bits() && image.Bits() != mGeometry.addrBits)
+	    {
+	        return false;
+	    }
+	    mRam.Load(image);
+	    return true;
+	}
+
+	bool Load(const WORD* image, size_t n)  // LoadProgram() + Reset(): ready to Run(); false (nothing loaded) if it does not fit
+	{
+	    if (n > mRam.Size())
+	    {
+	        return false;
+	    }
+	    mRam.Load(image, (WORD)n);
+	    Reset();
+	    return true;
+	}
+
+	void ReadRegs(WORD* regs)           // SC, PC, MAR, OPR, GPR, Acc, F
+	{
+	    memcpy(regs, mState.reg, sizeof(mState.reg));
+	}
+
+	size_t ReadMem(WORD first, size_t count, WORD* words)  // copies M[first..], stops at the end of memory; returns words copied
+	{
+	    size_t n = (first < mRam.Size()) ? std::min<size_t>(count, mRam.Size() - first) : 0;
+	    for (size_t i = 0; i < n; i++)
+	    {
+	        words[i] = mRam.Read((WORD)(first + i));
+	    }
+	    return n;
+	}
+
+	const CoreState& State()
+	{
+	    return mState;
+	}
+
+	void SaveSnapshot(Snapshot& s)      // registers, control word, memory and counters at a clock boundary
+	{
+	    s.version = SNAPSHOT_VERSION;
+	    s.addrBits = mGeometry.addrBits;
+	    s.cycles = mCycles;
+	    s.core = mState;
+	    s.counters = mCtrl.Counters();
+	    mRam.SavePages(s.pages, s.pageData);
+	}
+
+	bool RestoreSnapshot(const Snapshot& s)     // false (machine unchanged) for another version or Geometry
+	{
+	    if (s.version != SNAPSHOT_VERSION || s.addrBits != mGeometry.addrBits || !mRam.RestorePages(s.pages, s.pageData))
+	    {
+	        return false;
+	    }
+	    mState = s.core;
+	    mCycles = s.cycles;
+	    mCtrl.SetCounters(s.counters);
+	    RestartPacing();
+	    mTrace.Clear();                 // the records no longer lead up to this state
+	    if (mTrace.Writer()) mTrace.Writer()->Resync(mCycles);
+	    mRam.MarkAll();
+	    Rewound();
+	    return true;
+	}
+
+	void SetCheckpoints(uint64_t every, size_t keep = CHECKPOINT_KEEP)     // every 'every' clocks, 0 = off
+	{
+	    mCheckpoints.resize(keep ? keep : 1);
+	    mCheckpointFirst = mCheckpointCount = 0;
+	    mCheckpointEvery = every;
+	    Rewound();
+	}
+
+	size_t Checkpoints()                // automatic checkpoints held
+	{
+	    return mCheckpointCount;
+	}
+
+	bool Seek(uint64_t cycle)           // to clock 'cycle' of this run via the nearest checkpoint; false if HLT comes first
+	{
+	    const Snapshot* from = nullptr;
+	    for (size_t i = mCheckpointCount; i-- > 0; )
+	    {
+	        if (CheckpointAt(i).cycles <= cycle)
+	        {
+	            from = &CheckpointAt(i);
+	            break;
+	        }
+	    }
+
+	    if (cycle < mCycles || (from && from->cycles > mCycles))
+	    {
+	        if (from) RestoreSnapshot(*from);
+	        else Reload();              // nothing that early: start over from the image
+	    }
+	    if (cycle > mCycles) Run(cycle - mCycles);
+	    return mCycles == cycle;
+	}
+};
+
+
+/*******************************************************************************************************************
+
+                            FAST INTERPRETER
+    ------------------------------------------------------------------
+    Executes whole instructions against a flat MachineState instead of stepping the
+    microcode through the components. Every register an instruction touches on the
+    microcoded path (PC, MAR, GPR, OPR, Acc, F, Z, SC) ends up with the same value, and
+    the cycle count advances by the number of clocks the microcode would have taken:
+
+        fetch (3) + execute steps before CLRSC      CLRSC shares its clock with fetch step 0
+
+        CRA CTA ITA CRF CTF SFZ ROR ROL JMP  4      ADD STA JMPI  6      CSR  7
+        ADDI ISZ                             8      HLT           3 (stops with SC = 4)
+
+    State is compared at instruction boundaries: after fetch step 0 of the next
+    instruction (SC = 1, MAR = PC, Z = (GPR == 0)), i.e. where the microcoded machine
+    is one clock after CLRSC. Memory covers the full 8-bit MAR range; like LaneCpu, the
+    interpreter only implements the default Geometry (8-bit address, 12-bit data).
+
+    With SetBlockCache(true), Run() translates each straight-line run once - from the
+    current PC up to the first HLT, JMP, JMPI or CSR, at most BLOCK_MAX_OPS words - and
+    replays the translation from then on. The block becomes a list of BlockSteps: a run
+    of CRA, CTA, ITA, CRF and CTF folds into one step (Acc = mul x Acc + add,
+    F = (F & fand) ^ fxor), every other instruction keeps a step. SFZ and ISZ are side
+    exits: when they skip, the block ends there with PC one further. Replay keeps Acc, F
+    and GPR in locals, writes PC, MAR, OPR, Z and SC once and charges the clocks and
+    instructions of the steps that ran in one addition. A final JMP is the last step;
+    a final HLT, JMPI or CSR goes through the interpreter as usual.
+
+    Each address keeps a count of the blocks it belongs to; STA, CSR and ISZ stores into
+    a covered address drop the affected blocks, so self-modifying code (the CSR return
+    slot) stays exact. A store that drops the block being replayed ends it right after
+    that STA or ISZ, with the state as of that instruction. Load() only drops the blocks
+    over words it changes, so reloading an image keeps the blocks over its unchanged
+    code; FlushBlocks() resets only the blocks built since the last flush. A block only
+    runs as a whole if it fits in the remaining cycle budget, otherwise Run() falls back
+    to single instructions and stops exactly where the plain interpreter would.
+
+*******************************************************************************************************************/
+
+struct MachineState
+{
+    WORD pc, mar, gpr, opr, acc, flg, sc;   // flg: 0b0000'00ZF
+    WORD mem[256];
+};
+
+constexpr BYTE InstructionCycles[16] =      // clocks per opcode as in the table above, indexed by OPR
+{
+    3, 4, 4, 4, 4, 4, 4, 4, 4, 6, 8, 6, 4, 6, 7, 8
+};
+
+#define BLOCK_MAX_OPS   32              // longest straight-line run translated into one block
+
+struct BlockOp                          // pre-decoded instruction word
+{
+    WORD word;                          // value fetched into GPR
+    BYTE opcode;
+    BYTE ad;
+};
+
+enum BlockStepKind                      // BlockStep::kind
+{
+    STEP_ALU = 0,                       // a run of CRA/CTA/ITA/CRF/CTF
+    STEP_ROR,
+    STEP_ROL,
+    STEP_ADD,
+    STEP_ADDI,
+    STEP_STA,
+    STEP_SFZ,                           // side exit when F = 0
+    STEP_ISZ,                           // side exit when M + 1 = 0
+    STEP_JMP                            // last step of its block
+};
+
+struct BlockStep                        // one or more body instructions of a block, applied at once
+{
+    BYTE kind;
+    BYTE ad;                            // STEP_ADD/ADDI/STA
+    BYTE end;                           // instructions of the block up to and including this step
+    BYTE fand, fxor;                    // STEP_ALU: F = (F & fand) ^ fxor
+    WORD mul, add;                      // STEP_ALU: Acc = mul x Acc + add, mul 0, 1 or 0x0fff (-1)
+    WORD word;                          // last instruction word of the step, GPR after ALU/ROR/ROL
+    WORD cycles;                        // clocks of the block up to and including this step
+};
+
+struct Block                            // straight-line run ending at the first HLT/JMP/JMPI/CSR
+{
+    BYTE start;
+    BYTE length;                        // instructions, 0 = nothing cached at this address
+    BYTE steps;                         // used entries of step[]
+    BYTE listed;                        // start is in FastCpu::mBuilt
+    bool exits;                         // the block ends with HLT/JMPI/CSR in 'exit', else with a JMP step, at BLOCK_MAX_OPS or address 255
+    WORD cycles;                        // clocks of the whole block
+    BlockOp exit;
+    BlockStep step[BLOCK_MAX_OPS];
+};
+
+class FastCpu
+{
+private:
+
+    MachineState mState;
+    uint64_t mCycles;
+    uint64_t mInstructions;
+    bool mHalted;
+    std::vector<Block> mBlocks;         // indexed by start address, empty while the block cache is off
+    BYTE mCover[256];                   // number of cached blocks each address belongs to
+    BYTE mBuilt[256];                   // start of every block built since the last FlushBlocks()
+    int mBuiltCount;
+    uint64_t mBlocksBuilt;
+    uint64_t mBlocksDropped;
+
+    static BlockOp Decode(WORD word)
+    {
+        BlockOp op;
+        op.word = word & 0x0fff;
+        op.opcode = (op.word >> 8) & 0x000f;
+        op.ad = op.word & 0x00ff;
+        return op;
+    }
+
+    static bool EndsBlock(BYTE opcode)  // anything that leaves the straight line for good; SFZ and ISZ only skip one word
+    {
+        return opcode == OPC_HLT || opcode == OPC_JMP || opcode == OPC_JMPI || opcode == OPC_CSR;
+    }
+
+    void Drop(Block& b)
+    {
+        for (int i = 0; i < b.length; i++)
+        {
+            mCover[b.start + i]--;
+        }
+        b.length = 0;
+        mBlocksDropped++;
+    }
+
+    void Store(WORD ad, WORD value)     // memory write; drops every cached block that holds ad
+    {
+        mState.mem[ad] = value;
+        if (mCover[ad])
+        {
+            for (int i = 0; i < BLOCK_MAX_OPS && i <= ad; i++)
+            {
+                Block& b = mBlocks[ad - i];
+                if (b.length > i) Drop(b);
+            }
+        }
+    }
+
+    static void Fold(Block& b, const BlockOp& op, int end)  // appends a body instruction, into the last step if both are ALU
+    {
+        bool alu = op.opcode >= OPC_CRA && op.opcode <= OPC_CTF;
+        BlockStep* st = b.steps ? &b.step[b.steps - 1] : nullptr;
+
+        if (!alu || !st || st->kind != STEP_ALU)
+        {
+            st = &b.step[b.steps++];
+            st->kind = alu ? STEP_ALU :
+                (op.opcode == OPC_ROR) ? STEP_ROR :
+                (op.opcode == OPC_ROL) ? STEP_ROL :
+                (op.opcode == OPC_ADD) ? STEP_ADD :
+                (op.opcode == OPC_ADDI) ? STEP_ADDI :
+                (op.opcode == OPC_STA) ? STEP_STA :
+                (op.opcode == OPC_SFZ) ? STEP_SFZ :
+                (op.opcode == OPC_ISZ) ? STEP_ISZ : STEP_JMP;
+            st->mul = 1;
+            st->add = 0;
+            st->fand = 1;
+            st->fxor = 0;
+        }
+        st->ad = op.ad;
+        st->end = (BYTE)end;
+        st->word = op.word;
+        st->cycles = b.cycles;
+
+        switch (op.opcode)
+        {
+            case OPC_CRA:   st->mul = st->add = 0;                      break;
+            case OPC_CTA:   st->mul = (0x1000 - st->mul) & 0x0fff;
+                            st->add = (0x0fff - st->add) & 0x0fff;      break;
+            case OPC_ITA:   st->add = (st->add + 1) & 0x0fff;           break;
+            case OPC_CRF:   st->fand = st->fxor = 0;                    break;
+            case OPC_CTF:   st->fxor ^= 0x01;                           break;
+        }
+    }
+
+    Block& Build(WORD pc)
+    {
+        Block& b = mBlocks[pc];
+        int n = 0;
+
+        b.start = (BYTE)pc;
+        b.cycles = 0;
+        b.steps = 0;
+        b.exits = false;
+        for (WORD a = pc; a < 256 && n < BLOCK_MAX_OPS; a++)
+        {
+            BlockOp op = Decode(mState.mem[a]);
+            n++;
+            b.cycles += InstructionCycles[op.opcode];
+            if (op.opcode == OPC_JMP)
+            {
+                Fold(b, op, n);
+                break;
+            }
+            if (EndsBlock(op.opcode))
+            {
+                b.exit = op;
+                b.exits = true;
+                break;
+            }
+            Fold(b, op, n);
+        }
+        b.length = (BYTE)n;
+        for (int i = 0; i < n; i++)
+        {
+            mCover[pc + i]++;
+        }
+        if (!b.listed)
+        {
+            b.listed = 1;
+            mBuilt[mBuiltCount++] = (BYTE)pc;
+        }
+        mBlocksBuilt++;
+        return b;
+    }
+
+    bool Execute(const BlockOp& op)     // fetch steps 1-2 and the execute cycle; false once halted
+    {
+        MachineState& s = mState;
+        WORD f, a;
+        WORD ad = op.ad;
+
+        s.gpr = op.word;                // M -> GPR, PC + 1 -> PC
+        s.pc = (s.pc + 1) & 0x00ff;
+        s.opr = op.opcode;              // GPR(OP) -> OPR
+        f = s.flg & 0x0001;
+
+        switch (op.opcode)
+        {
+            case OPC_HLT:
+                s.flg = f | ((s.gpr == 0) << 1);
+                s.sc = 4;
+                mCycles += InstructionCycles[OPC_HLT];
+                mInstructions++;            // retired like any other instruction (cf. PerfCounters)
+                mHalted = true;
+                return false;
+
+            case OPC_CRA:   s.acc = 0;                              break;
+            case OPC_CTA:   s.acc = ~s.acc & 0x0fff;                break;
+            case OPC_ITA:   s.acc = (s.acc + 1) & 0x0fff;           break;
+            case OPC_CRF:   f = 0;                                  break;
+            case OPC_CTF:   f ^= 0x0001;                            break;
+            case OPC_SFZ:   if (!f) s.pc = (s.pc + 1) & 0x00ff;     break;
+
+            case OPC_ROR:
+                a = s.acc & 0x0001;
+                s.acc = (s.acc >> 1) | (f << 11);
+                f = a;
+                break;
+
+            case OPC_ROL:
+                a = (s.acc >> 11) & 0x0001;
+                s.acc = ((s.acc << 1) & 0x0fff) | f;
+                f = a;
+                break;
+
+            case OPC_ADD:
+                s.mar = ad;
+                s.gpr = s.mem[s.mar] & 0x0fff;
+                s.acc = (s.acc + s.gpr) & 0x0fff;
+                break;
+
+            case OPC_ADDI:
+                s.mar = ad;
+                s.gpr = s.mem[s.mar] & 0x0fff;
+                s.mar = s.gpr & 0x00ff;
+                s.gpr = s.mem[s.mar] & 0x0fff;
+                s.acc = (s.acc + s.gpr) & 0x0fff;
+                break;
+
+            case OPC_STA:
+                s.mar = ad;
+                s.gpr = s.acc;
+                Store(s.mar, s.gpr);
+                break;
+
+            case OPC_JMP:
+                s.pc = ad;
+                break;
+
+            case OPC_JMPI:
+                s.mar = ad;
+                s.gpr = s.mem[s.mar] & 0x0fff;
+                s.pc = s.gpr & 0x00ff;
+                break;
+
+            case OPC_CSR:                   // return address goes to the first word of the subroutine
+                s.mar = ad;
+                s.gpr = s.pc;
+                s.pc = ad;
+                Store(s.mar, s.gpr);
+                s.pc = (s.pc + 1) & 0x00ff;
+                break;
+
+            default:                        // OPC_ISZ
+                s.mar = ad;
+                s.gpr = ((s.mem[s.mar] & 0x0fff) + 1) & 0x0fff;
+                Store(s.mar, s.gpr);
+                if (s.gpr == 0) s.pc = (s.pc + 1) & 0x00ff;
+                break;
+        }
+
+        s.mar = s.pc;                       // CLRSC + PC -> MAR of the next instruction
+        s.flg = f | ((s.gpr == 0) << 1);
+        s.sc = 1;
+        mCycles += InstructionCycles[op.opcode];
+        mInstructions++;
+        return true;
+    }
+
+    bool Replay(Block& b)               // the body's steps, then the last instruction; false once halted
+    {
+        MachineState& s = mState;
+        WORD acc = s.acc, gpr = s.gpr, f = s.flg & 0x0001, bit;
+        bool skip = false;
+        const BlockStep* st = b.step;
+        const BlockStep* stop = b.step + b.steps;
+
+        while (st < stop)
+        {
+            switch (st->kind)
+            {
+                case STEP_ALU:
+                    acc = (st->mul * acc + st->add) & 0x0fff;
+                    f = (f & st->fand) ^ st->fxor;
+                    gpr = st->word;
+                    break;
+
+                case STEP_ROR:
+                    bit = acc & 0x0001;
+                    acc = (acc >> 1) | (f << 11);
+                    f = bit;
+                    gpr = st->word;
+                    break;
+
+                case STEP_ROL:
+                    bit = (acc >> 11) & 0x0001;
+                    acc = ((acc << 1) & 0x0fff) | f;
+                    f = bit;
+                    gpr = st->word;
+                    break;
+
+                case STEP_ADD:
+                    gpr = s.mem[st->ad] & 0x0fff;
+                    acc = (acc + gpr) & 0x0fff;
+                    break;
+
+                case STEP_ADDI:
+                    gpr = s.mem[s.mem[st->ad] & 0x00ff] & 0x0fff;
+                    acc = (acc + gpr) & 0x0fff;
+                    break;
+
+                case STEP_STA:
+                    gpr = acc;
+                    Store(st->ad, gpr);
+                    break;
+
+                case STEP_SFZ:
+                    gpr = st->word;
+                    skip = !f;
+                    break;
+
+                case STEP_ISZ:
+                    gpr = ((s.mem[st->ad] & 0x0fff) + 1) & 0x0fff;
+                    Store(st->ad, gpr);
+                    skip = (gpr == 0);
+                    break;
+
+                default:                    // STEP_JMP, always the last one
+                    gpr = st->word;
+                    break;
+            }
+            st++;
+            if (skip || b.length == 0)      // a skip, or a store that dropped this very block: stop after it
+            {
+                break;
+            }
+        }
+
+        if (st != b.step)                   // the state after the last body instruction that ran
+        {
+            const BlockStep& last = st[-1];
+            s.acc = acc;
+            s.gpr = gpr;
+            s.pc = (last.kind == STEP_JMP) ? last.ad : (b.start + last.end + skip) & 0x00ff;
+            s.opr = (last.word >> 8) & 0x000f;
+            s.mar = s.pc;
+            s.flg = f | ((gpr == 0) << 1);
+            s.sc = 1;
+            mCycles += last.cycles;
+            mInstructions += last.end;
+        }
+        if (skip || b.length == 0 || !b.exits)
+        {
+            return true;
+        }
+        return Execute(b.exit);
+    }
+
+    RunStatus RunBlocks(uint64_t maxCycles)
+    {
+        uint64_t start = mCycles;
+        while (!mHalted && (mCycles - start) < maxCycles)
+        {
+            Block* b = &mBlocks[mState.mar];    // MAR = PC at every instruction boundary
+            if (b->length == 0)
+            {
+                b = &Build(mState.mar);
+            }
+            if ((mCycles - start) + b->cycles > maxCycles)
+            {
+                Step();                     // the budget ends inside this block: stop where Run() would
+                continue;
+            }
+            Replay(*b);
+        }
+        return mHalted ? RUN_HALTED : RUN_PAUSED;
+    }
+
+public:
+
+    FastCpu()
+    {
+        memset(&mState, 0, sizeof(mState));
+        memset(mCover, 0, sizeof(mCover));
+        mBuiltCount = 0;
+        mBlocksBuilt = mBlocksDropped = 0;
+        Reset();
+    }
+
+    void Load(const WORD* image, size_t n)  // copies the image to address 0, clears the rest; blocks over unchanged words stay
+    {
+        if (n > 256) n = 256;
+        for (int i = 0; i < mBuiltCount; i++)
+        {
+            Block& b = mBlocks[mBuilt[i]];
+            for (int k = 0; k < b.length; k++)
+            {
+                size_t a = b.start + k;
+                if (mState.mem[a] != ((a < n) ? image[a] : 0))
+                {
+                    Drop(b);
+                    break;
+                }
+            }
+        }
+        memset(mState.mem, 0, sizeof(mState.mem));
+        memcpy(mState.mem, image, n * sizeof(WORD));
+    }
+
+    void Reset()                        // clears the registers and performs fetch step 0 (PC -> MAR)
+    {
+        mState.pc = mState.gpr = mState.opr = mState.acc = 0;
+        mState.mar = 0;
+        mState.flg = 0x0002;            // Z = 1, GPR = 0
+        mState.sc = 1;
+        mCycles = 1;
+        mInstructions = 0;
+        mHalted = false;
+    }
+
+    void SetBlockCache(bool on)         // translate straight-line runs once and replay them from the cache
+    {
+        if (on == !mBlocks.empty()) return;
+        if (on) mBlocks.assign(256, Block());
+        else mBlocks.clear();
+        memset(mCover, 0, sizeof(mCover));
+        mBuiltCount = 0;
+    }
+
+    void FlushBlocks()                  // required after writing State().mem directly
+    {
+        for (int i = 0; i < mBuiltCount; i++)
+        {
+            Block& b = mBlocks[mBuilt[i]];
+            b.length = 0;
+            b.listed = 0;
+        }
+        mBuiltCount = 0;
+        memset(mCover, 0, sizeof(mCover));
+    }
+
+    bool Step()                         // one instruction; returns false once halted
+    {
+        if (mHalted)
+        {
+            return false;
+        }
+        return Execute(Decode(mState.mem[mState.mar]));
+    }
+
+    RunStatus Run(uint64_t maxCycles)   // whole instructions until HLT or the budget is reached (may overshoot by < 8)
+    {
+        if (!mBlocks.empty())
+        {
+            return RunBlocks(maxCycles);
+        }
+        uint64_t start = mCycles;
+        while ((mCycles - start) < maxCycles && Step())
+        {
+        }
+        return mHalted ? RUN_HALTED : RUN_PAUSED;
+    }
+
+    bool Halted()
+    {
+        return mHalted;
+    }
+
+    uint64_t Cycles()
+    {
+        return mCycles;
+    }
+
+    uint64_t Instructions()
+    {
+        return mInstructions;
+    }
+
+    uint64_t BlocksBuilt()
+    {
+        return mBlocksBuilt;
+    }
+
+    uint64_t BlocksDropped()            // invalidated by a store into their words
+    {
+        return mBlocksDropped;
+    }
+
+    MachineState& State()
+    {
+        return mState;
+    }
+
+    void ReadRegs(WORD* regs)           // SC, PC, MAR, OPR, GPR, Acc, F
+    {
+        const WORD r[] = { mState.sc, mState.pc, mState.mar, mState.opr, mState.gpr, mState.acc, mState.flg };
+        memcpy(regs, r, sizeof(r));
+    }
+
+    void DisplayRegs(std::ostream& os = std::cout)  // same order as Computer::DisplayRegs()
+    {
+        WORD regs[7];
+        ReadRegs(regs);
+        for (WORD r : regs)
+        {
+            os << "\nReg -> " << r << "\n";
+        }
+    }
+};
+
+
+/*******************************************************************************************************************
+
+                            LOCKSTEP LANES
+    ------------------------------------------------------------------
+    Runs LANES copies of one program side by side - typically the same image with
+    different data words (NUMA/NUMB/NUMC at 19-21 for the default program). The state is
+    kept as structure-of-arrays: every register is an array indexed by lane, and memory
+    is stored address-major, mem[address][lane], so an instruction reads and writes one
+    contiguous row across all lanes. Instruction semantics, cycle counts and the final
+    state of every lane are exactly those of FastCpu.
+
+    Each step issues one instruction word for a mask of lanes:
+
+        leader      the runnable lane with the lowest PC
+        mask        every runnable lane at the leader's PC holding the same word there
+        idle        all other lanes keep their state (the results are blended in)
+
+    Lanes split where their data differ (SFZ, ISZ, JMPI, or a word changed by a store)
+    and merge again as soon as they meet at the same PC; running the lowest PC first
+    lets the lanes behind catch up with those ahead. A lane drops out at HLT or once its
+    own cycle budget is used up.
+
+    The lane loops are plain fixed-length loops over WORD arrays, written for the
+    compiler's auto-vectorizer (32 lanes x 16 bit = one 512-bit or two 256-bit
+    registers); no intrinsics are used. ADDI is the only gather, its second address
+    being per lane. Clocks and instructions are counted per step in 32-bit lanes and
+    folded into the 64-bit totals at every budget check and at the end of Run(). As
+    long as the lanes stay together, the next PC is known and the lowest-PC search is
+    skipped. Utilization() = lane instructions / (issued steps x LANES), 1.0 while no
+    lane diverges.
+
+        --sweep runs [address]      runs of the image with word address (default 19,
+                                    NUMA) = 0..runs-1, lockstep vs one FastCpu at a
+                                    time, every lane checked against FastCpu
+
+*******************************************************************************************************************/
+
+#define LANES               32          // machines per LaneCpu, one 64-byte row per address
+#define LANE_FOLD_STEPS     (1 << 24)   // steps between folds of the 32-bit lane counters
+#define SWEEP_MAX_CYCLES    1000000     // per-run budget of --sweep
+
+class LaneCpu
+{
+private:
+
+    struct alignas(64) LaneState
+    {
+        WORD pc[LANES], mar[LANES], gpr[LANES], opr[LANES], acc[LANES], flg[LANES], sc[LANES];
+        WORD mem[256][LANES];           // address-major: one row = one address in every lane
+    };
+
+    LaneState mState;
+    alignas(64) WORD mImage[256][LANES];    // as loaded, restored by Reload()
+    WORD mMask[LANES];                  // 0xffff = lane takes part in the current step
+    WORD mLive[LANES];                  // 0xffff = lane not halted and within the budget of Run()
+    WORD mHalted[LANES];                // 0xffff once the lane has executed HLT
+    uint32_t mTicks[LANES];             // clocks and instructions since the last Fold()
+    uint32_t mRetired[LANES];
+    uint64_t mCycles[LANES];
+    uint64_t mInstructions[LANES];
+    uint64_t mSteps;                    // instruction words issued
+    uint64_t mLaneSteps;                // lane instructions executed by those steps
+
+    static WORD Blend(WORD k, WORD old, WORD now)
+    {
+        return (WORD)((old & ~k) | (now & k));
+    }
+
+    static WORD When(bool c)            // condition as a lane mask
+    {
+        return (WORD)(0 - (WORD)c);
+    }
+
+    void Execute(WORD pc, WORD word)    // one instruction for every lane in mMask, all of them at pc
+    {
+        LaneState& s = mState;
+        WORD opcode = (word >> 8) & 0x000f;
+        WORD ad = word & 0x00ff;
+        WORD next = (pc + 1) & 0x00ff;
+        WORD skip = (pc + 2) & 0x00ff;
+        int n = 0;
+
+        for (int l = 0; l < LANES; l++)     // M -> GPR, PC + 1 -> PC, GPR(OP) -> OPR
+        {
+            s.gpr[l] = Blend(mMask[l], s.gpr[l], word);
+            s.pc[l] = Blend(mMask[l], s.pc[l], next);
+            s.opr[l] = Blend(mMask[l], s.opr[l], opcode);
+        }
+
+        switch (opcode)                 // F is carried in bit 0 of flg until the epilogue sets Z
+        {
+            case OPC_HLT:
+                for (int l = 0; l < LANES; l++)
+                {
+                    s.flg[l] = Blend(mMask[l], s.flg[l], (s.flg[l] & 0x0001) | ((word == 0) << 1));
+                    s.sc[l] = Blend(mMask[l], s.sc[l], 4);
+                }
+                for (int l = 0; l < LANES; l++)
+                {
+                    n += mMask[l] & 1;
+                    mTicks[l] += InstructionCycles[OPC_HLT] & mMask[l];
+                    mRetired[l] += mMask[l] & 1;
+                    mHalted[l] |= mMask[l];
+                    mLive[l] &= ~mMask[l];
+                }
+                mSteps++;
+                mLaneSteps += n;
+                return;
+
+            case OPC_CRA:
+                for (int l = 0; l < LANES; l++) s.acc[l] = Blend(mMask[l], s.acc[l], 0);
+                break;
+
+            case OPC_CTA:
+                for (int l = 0; l < LANES; l++) s.acc[l] = Blend(mMask[l], s.acc[l], ~s.acc[l] & 0x0fff);
+                break;
+
+            case OPC_ITA:
+                for (int l = 0; l < LANES; l++) s.acc[l] = Blend(mMask[l], s.acc[l], (s.acc[l] + 1) & 0x0fff);
+                break;
+
+            case OPC_CRF:
+                for (int l = 0; l < LANES; l++) s.flg[l] = Blend(mMask[l], s.flg[l], 0);
+                break;
+
+            case OPC_CTF:
+                for (int l = 0; l < LANES; l++) s.flg[l] = Blend(mMask[l], s.flg[l], (s.flg[l] & 0x0001) ^ 0x0001);
+                break;
+
+            case OPC_SFZ:
+                for (int l = 0; l < LANES; l++) s.pc[l] = Blend(mMask[l] & When(!(s.flg[l] & 0x0001)), s.pc[l], skip);
+                break;
+
+            case OPC_ROR:
+                for (int l = 0; l < LANES; l++)
+                {
+                    WORD a = s.acc[l];
+                    s.acc[l] = Blend(mMask[l], a, (a >> 1) | ((s.flg[l] & 0x0001) << 11));
+                    s.flg[l] = Blend(mMask[l], s.flg[l], a & 0x0001);
+                }
+                break;
+
+            case OPC_ROL:
+                for (int l = 0; l < LANES; l++)
+                {
+                    WORD a = s.acc[l];
+                    s.acc[l] = Blend(mMask[l], a, ((a << 1) & 0x0fff) | (s.flg[l] & 0x0001));
+                    s.flg[l] = Blend(mMask[l], s.flg[l], (a >> 11) & 0x0001);
+                }
+                break;
+
+            case OPC_ADD:
+                for (int l = 0; l < LANES; l++)
+                {
+                    WORD v = s.mem[ad][l] & 0x0fff;
+                    s.mar[l] = Blend(mMask[l], s.mar[l], ad);
+                    s.gpr[l] = Blend(mMask[l], s.gpr[l], v);
+                    s.acc[l] = Blend(mMask[l], s.acc[l], (s.acc[l] + v) & 0x0fff);
+                }
+                break;
+
+            case OPC_ADDI:
+                for (int l = 0; l < LANES; l++)
+                {
+                    WORD a = s.mem[ad][l] & 0x00ff;
+                    WORD v = s.mem[a][l] & 0x0fff;
+                    s.mar[l] = Blend(mMask[l], s.mar[l], a);
+                    s.gpr[l] = Blend(mMask[l], s.gpr[l], v);
+                    s.acc[l] = Blend(mMask[l], s.acc[l], (s.acc[l] + v) & 0x0fff);
+                }
+                break;
+
+            case OPC_STA:
+                for (int l = 0; l < LANES; l++)
+                {
+                    s.mar[l] = Blend(mMask[l], s.mar[l], ad);
+                    s.gpr[l] = Blend(mMask[l], s.gpr[l], s.acc[l]);
+                    s.mem[ad][l] = Blend(mMask[l], s.mem[ad][l], s.acc[l]);
+                }
+                break;
+
+            case OPC_JMP:
+                for (int l = 0; l < LANES; l++) s.pc[l] = Blend(mMask[l], s.pc[l], ad);
+                break;
+
+            case OPC_JMPI:
+                for (int l = 0; l < LANES; l++)
+                {
+                    WORD v = s.mem[ad][l] & 0x0fff;
+                    s.mar[l] = Blend(mMask[l], s.mar[l], ad);
+                    s.gpr[l] = Blend(mMask[l], s.gpr[l], v);
+                    s.pc[l] = Blend(mMask[l], s.pc[l], v & 0x00ff);
+                }
+                break;
+
+            case OPC_CSR:                   // return address goes to the first word of the subroutine
+                for (int l = 0; l < LANES; l++)
+                {
+                    s.mar[l] = Blend(mMask[l], s.mar[l], ad);
+                    s.gpr[l] = Blend(mMask[l], s.gpr[l], next);
+                    s.mem[ad][l] = Blend(mMask[l], s.mem[ad][l], next);
+                    s.pc[l] = Blend(mMask[l], s.pc[l], (ad + 1) & 0x00ff);
+                }
+                break;
+
+            default:                        // OPC_ISZ
+                for (int l = 0; l < LANES; l++)
+                {
+                    WORD v = ((s.mem[ad][l] & 0x0fff) + 1) & 0x0fff;
+                    s.mar[l] = Blend(mMask[l], s.mar[l], ad);
+                    s.gpr[l] = Blend(mMask[l], s.gpr[l], v);
+                    s.mem[ad][l] = Blend(mMask[l], s.mem[ad][l], v);
+                    s.pc[l] = Blend(mMask[l] & When(v == 0), s.pc[l], skip);
+                }
+                break;
+        }
+
+        for (int l = 0; l < LANES; l++)     // CLRSC + PC -> MAR of the next instruction
+        {
+            s.mar[l] = Blend(mMask[l], s.mar[l], s.pc[l]);
+            s.flg[l] = Blend(mMask[l], s.flg[l], (s.flg[l] & 0x0001) | ((s.gpr[l] == 0) << 1));
+            s.sc[l] = Blend(mMask[l], s.sc[l], 1);
+        }
+        for (int l = 0; l < LANES; l++)
+        {
+            n += mMask[l] & 1;
+            mTicks[l] += InstructionCycles[opcode] & mMask[l];
+            mRetired[l] += mMask[l] & 1;
+        }
+        mSteps++;
+        mLaneSteps += n;
+    }
+
+    void Fold()                         // the narrow per-step counters into the 64-bit totals
+    {
+        for (int l = 0; l < LANES; l++)
+        {
+            mCycles[l] += mTicks[l];
+            mInstructions[l] += mRetired[l];
+            mTicks[l] = mRetired[l] = 0;
+        }
+    }
+
+public:
+
+    LaneCpu()
+    {
+        memset(&mState, 0, sizeof(mState));
+        Reset();
+    }
+
+    void Load(const WORD* image, size_t n)  // the same image in every lane, the rest cleared
+    {
+        if (n > 256) n = 256;
+        for (size_t a = 0; a < 256; a++)
+        {
+            for (int l = 0; l < LANES; l++)
+            {
+                mImage[a][l] = (a < n) ? image[a] : 0;
+            }
+        }
+        Reload();
+    }
+
+    void Reload()                       // back to the image as loaded, undoing stores and SetWord()
+    {
+        memcpy(mState.mem, mImage, sizeof(mImage));
+    }
+
+    void SetWord(int lane, WORD addr, WORD value)   // per-lane data, after Load() or Reload()
+    {
+        mState.mem[addr & 0x00ff][lane] = value;
+    }
+
+    WORD Word(int lane, WORD addr)
+    {
+        return mState.mem[addr & 0x00ff][lane];
+    }
+
+    void Reset()                        // every lane as after FastCpu::Reset()
+    {
+        for (int l = 0; l < LANES; l++)
+        {
+            mState.pc[l] = mState.gpr[l] = mState.opr[l] = mState.acc[l] = 0;
+            mState.mar[l] = 0;
+            mState.flg[l] = 0x0002;
+            mState.sc[l] = 1;
+            mCycles[l] = 1;
+            mInstructions[l] = 0;
+            mTicks[l] = mRetired[l] = 0;
+            mHalted[l] = 0;
+        }
+        mSteps = mLaneSteps = 0;
+    }
+
+    RunStatus Run(uint64_t maxCycles)   // until every lane has halted or used up its own budget
+    {
+        LaneState& s = mState;
+        uint64_t start[LANES];
+        uint64_t check = 0;             // steps left before any lane can reach its budget
+        bool together = false;          // every live lane is at pc
+        WORD pc = 0;
+        WORD halted = 0xffff;
+
+        memcpy(start, mCycles, sizeof(start));
+        for (int l = 0; l < LANES; l++)
+        {
+            mLive[l] = (WORD)~mHalted[l];
+        }
+        for (;; check--)
+        {
+            if (check == 0)             // a step adds at most 8 clocks to a lane
+            {
+                uint64_t room = UINT64_MAX;
+                Fold();
+                for (int l = 0; l < LANES; l++)
+                {
+                    uint64_t used = mCycles[l] - start[l];
+                    if (used >= maxCycles) mLive[l] = 0, together = false;
+                    else if (mLive[l] && maxCycles - used < room) room = maxCycles - used;
+                }
+                check = (room - 1) / 8 + 1;
+                if (check > LANE_FOLD_STEPS) check = LANE_FOLD_STEPS;
+            }
+
+            if (!together)              // lowest PC among the live lanes; MAR = PC at every instruction boundary
+            {
+                pc = 0xffff;
+                for (int l = 0; l < LANES; l++)
+                {
+                    WORD key = Blend(mLive[l], 0xffff, s.mar[l]);
+                    pc = (key < pc) ? key : pc;
+                }
+                if (pc == 0xffff) break;
+            }
+            int lead = 0;
+            while (!(mLive[lead] && s.mar[lead] == pc)) lead++;
+
+            WORD word = s.mem[pc][lead] & 0x0fff;
+            WORD opcode = (word >> 8) & 0x000f;
+            WORD apart = 0;
+            for (int l = 0; l < LANES; l++)
+            {
+                mMask[l] = mLive[l] & When(s.mar[l] == pc) & When((s.mem[pc][l] & 0x0fff) == word);
+                apart |= mLive[l] ^ mMask[l];
+            }
+            Execute(pc, word);
+
+            together = !apart && opcode != OPC_HLT && opcode != OPC_SFZ && opcode != OPC_ISZ && opcode != OPC_JMPI;
+            pc = s.mar[lead];           // the next PC of every lane when they stay together
+        }
+        Fold();
+
+        for (int l = 0; l < LANES; l++)
+        {
+            halted &= mHalted[l];
+        }
+        return halted ? RUN_HALTED : RUN_PAUSED;
+    }
+
+    bool Halted(int lane)
+    {
+        return mHalted[lane] != 0;
+    }
+
+    uint64_t Cycles(int lane)
+    {
+        return mCycles[lane];
+    }
+
+    uint64_t Instructions(int lane)
+    {
+        return mInstructions[lane];
+    }
+
+    uint64_t Steps()
+    {
+        return mSteps;
+    }
+
+    uint64_t LaneSteps()
+    {
+        return mLaneSteps;
+    }
+
+    double Utilization()
+    {
+        return mSteps ? mLaneSteps / (double)(mSteps * LANES) : 0.0;
+    }
+
+    void ReadRegs(int lane, WORD* regs) // SC, PC, MAR, OPR, GPR, Acc, F
+    {
+        const LaneState& s = mState;
+        const WORD r[] = { s.sc[lane], s.pc[lane], s.mar[lane], s.opr[lane], s.gpr[lane], s.acc[lane], s.flg[lane] };
+        memcpy(regs, r, sizeof(r));
+    }
+
+    void ReadMem(int lane, WORD* mem)   // 256 words
+    {
+        for (int a = 0; a < 256; a++)
+        {
+            mem[a] = mState.mem[a][lane];
+        }
+    }
+
+    int Differs(const WORD* mem, WORD& addr)    // first lane whose 256 words are not mem, -1 if every lane matches
+    {
+        for (int a = 0; a < 256; a++)   // row by row: one compare per lane, no gather
+        {
+            WORD apart = 0;
+            for (int l = 0; l < LANES; l++)
+            {
+                apart |= mState.mem[a][l] ^ mem[a];
+            }
+            if (apart)
+            {
+                int l = 0;
+                while (mState.mem[a][l] == mem[a]) l++;
+                addr = (WORD)a;
+                return l;
+            }
+        }
+        return -1;
+    }
+};
+
+/*******************************************************************************************************************
+
+                            PROFILER
+    ------------------------------------------------------------------
+     input          Computer::Profile(): instructions fetched per address, one counter
+                    increment per instruction in Control (CLRSC), nothing else at run time
+     hot spots      count x InstructionCycles[] of the word now at the address
+     routine        slot S of a CSR S that ran; body S+1 up to the first JMPI S
+     call arc       caller (routine holding the CSR, else main) -> routine S, the
+                    CSR's count is the number of calls
+     total          self + calls x (total / calls) of every callee, as gprof does
+     folded         "main;DBL 57" lines, clocks per call stack, for flamegraph.pl
+                    or speedscope
+    ------------------------------------------------------------------
+
+    Everything but the counts is worked out afterwards from the memory image, so the
+    run loop is not slowed down by call tracking. Code that rewrote itself is costed
+    as it is at the end of the run, an instruction still running when the run stopped
+    counts in full, and a routine called from two places splits its total between
+    them in proportion to the calls.
+
+*******************************************************************************************************************/
+
+#define PROFILE_HOT_SPOTS   16          // addresses listed by Display()
+
+class Profiler
+{
+private:
+    struct Routine
+    {
+        std::string name;
+        WORD slot;                      // return address word, main: none
+        WORD last;                      // address of the JMPI back
+        uint64_t calls;
+        uint64_t selfClocks;
+        double total;                   // clocks including callees
+        std::vector<std::pair<size_t, uint64_t>> callees;   // routine, calls
+    };
+
+    std::vector<uint64_t> mCounts;
+    std::vector<WORD> mWords;
+    std::vector<int> mOwner;            // routine of each address, 0 = main
+    std::vector<Routine> mRoutines;     // [0] = main
+    const std::vector<Symbol>* mSymbols;
+    BYTE mAddrBits;
+    uint64_t mInstructions;
+    uint64_t mClocks;
+
+    BYTE Opcode(WORD a)
+    {
+        return (BYTE)((mWords[a] >> mAddrBits) & 0x0f);
+    }
+
+    WORD Address(WORD a)
+    {
+        return (WORD)(mWords[a] & ((1u << mAddrBits) - 1));
+    }
+
+    uint64_t Clocks(WORD a)
+    {
+        return mCounts[a] * InstructionCycles[Opcode(a)];
+    }
+
+    std::string Name(WORD a)            // symbol at a, or sub_a
+    {
+        if (mSymbols)
+        {
+            for (const Symbol& s : *mSymbols)
+            {
+                if (s.addr == a) return s.name;
+            }
+        }
+        return "sub_" + std::to_string(a);
+    }
+
+    double Total(size_t r, std::vector<BYTE>& state)    // 1 = on the stack: a recursive call adds nothing
+    {
+        Routine& rt = mRoutines[r];
+        if (state[r] == 2) return rt.total;
+        if (state[r] == 1) return 0.0;
+        state[r] = 1;
+        rt.total = (double)rt.selfClocks;
+        for (auto& c : rt.callees)
+        {
+            double callee = Total(c.first, state);
+            rt.total += mRoutines[c.first].calls ? callee * c.second / mRoutines[c.first].calls : 0.0;
+        }
+        state[r] = 2;
+        return rt.total;
+    }
+
+    void Fold(std::ostream& os, size_t r, const std::string& stack, double share, std::vector<BYTE>& onStack)
+    {
+        const Routine& rt = mRoutines[r];
+        uint64_t self = (uint64_t)(rt.selfClocks * share + 0.5);
+        if (self) os << stack << " " << self << "\n";
+        onStack[r] = 1;
+        for (auto& c : rt.callees)
+        {
+            const Routine& callee = mRoutines[c.first];
+            if (!onStack[c.first] && callee.calls)
+            {
+                Fold(os, c.first, stack + ";" + callee.name, share * c.second / callee.calls, onStack);
+            }
+        }
+        onStack[r] = 0;
+    }
+
+public:
+    Profiler() : mSymbols(nullptr), mAddrBits(ADDR_BITS), mInstructions(0), mClocks(0)
+    {
+    }
+
+    void Analyze(Computer& cpu, const std::vector<Symbol>* symbols = nullptr)   // after the profiled run
+    {
+        WORD n = cpu.Ram().Size();
+
+        mCounts = cpu.Profile();
+        mCounts.resize(n);
+        mWords.resize(n);
+        for (WORD a = 0; a < n; a++) mWords[a] = cpu.Ram().Read(a);
+        mAddrBits = cpu.Layout().addrBits;
+        mSymbols = symbols;
+        mRoutines.assign(1, Routine{ "main", 0, 0, 1, 0, 0.0, {} });
+        mOwner.assign(n, 0);
+
+        for (WORD a = 0; a < n; a++)    // routines: every slot a CSR that ran jumped through
+        {
+            if (!mCounts[a] || Opcode(a) != OPC_CSR) continue;
+            WORD slot = Address(a);
+            size_t r = 1;
+            while (r < mRoutines.size() && mRoutines[r].slot != slot) r++;
+            if (r < mRoutines.size()) continue;
+            WORD last = slot;
+            while (last + 1 < n && !(Opcode(last + 1) == OPC_JMPI && Address(last + 1) == slot)) last++;
+            mRoutines.push_back(Routine{ Name(slot), slot, (WORD)(last + 1 < n ? last + 1 : last), 0, 0, 0.0, {} });
+        }
+        for (size_t r = 1; r < mRoutines.size(); r++)   // innermost (latest starting) routine owns an address
+        {
+            for (WORD a = mRoutines[r].slot + 1; a <= mRoutines[r].last && a < n; a++)
+            {
+                if (!mOwner[a] || mRoutines[mOwner[a]].slot < mRoutines[r].slot) mOwner[a] = (int)r;
+            }
+        }
+
+        mInstructions = mClocks = 0;
+        for (WORD a = 0; a < n; a++)
+        {
+            if (!mCounts[a]) continue;
+            Routine& owner = mRoutines[mOwner[a]];
+            mInstructions += mCounts[a];
+            mClocks += Clocks(a);
+            owner.selfClocks += Clocks(a);
+            if (Opcode(a) == OPC_CSR)
+            {
+                size_t callee = 1;
+                while (mRoutines[callee].slot != Address(a)) callee++;
+                mRoutines[callee].calls += mCounts[a];
+                auto arc = std::find_if(owner.callees.begin(), owner.callees.end(), [&](auto& c) { return c.first == callee; });
+                if (arc == owner.callees.end()) owner.callees.push_back({ callee, mCounts[a] });
+                else arc->second += mCounts[a];
+            }
+        }
+        std::vector<BYTE> state(mRoutines.size(), 0);
+        for (size_t r = 0; r < mRoutines.size(); r++) Total(r, state);
+    }
+
+    void Display(std::ostream& os)
+    {
+        std::vector<WORD> hot;
+        for (WORD a = 0; a < (WORD)mCounts.size(); a++)
+        {
+            if (mCounts[a]) hot.push_back(a);
+        }
+        std::stable_sort(hot.begin(), hot.end(), [&](WORD a, WORD b) { return Clocks(a) > Clocks(b); });
+        if (hot.size() > PROFILE_HOT_SPOTS) hot.resize(PROFILE_HOT_SPOTS);
+        double pct = mClocks ? 100.0 / mClocks : 0.0;
+
+        os << "\n****** PROFILE ****** " << mInstructions << " instructions, " << mClocks << " clocks\n";
+        os << "addr\tcount\tclocks\t%\tinstruction\n";
+        for (WORD a : hot)
+        {
+            os << a << "\t" << mCounts[a] << "\t" << Clocks(a) << "\t" << Clocks(a) * pct << "\t"
+               << OpcodeTable[Opcode(a)].mnemonic;
+            if (OpcodeTable[Opcode(a)].address) os << " " << Address(a);
+            os << "\t" << mRoutines[mOwner[a]].name << "\n";
+        }
+        os << "\nroutine\taddr\tcalls\tself\t%\ttotal\t%\n";
+        for (const Routine& r : mRoutines)
+        {
+            if (&r == &mRoutines[0]) os << r.name << "\t-";
+            else os << r.name << "\t" << r.slot << "-" << r.last;
+            os << "\t" << r.calls << "\t" << r.selfClocks << "\t" << r.selfClocks * pct << "\t"
+               << (uint64_t)(r.total + 0.5) << "\t" << r.total * pct << "\n";
+        }
+        os << "\ncall graph\n";
+        for (const Routine& r : mRoutines)
+        {
+            for (auto& c : r.callees)
+            {
+                os << r.name << " -> " << mRoutines[c.first].name << "\t" << c.second << " calls\n";
+            }
+        }
+    }
+
+    void WriteFolded(std::ostream& os)  // flamegraph input, clocks per stack
+    {
+        std::vector<BYTE> onStack(mRoutines.size(), 0);
+        Fold(os, 0, "main", 1.0, onStack);
+    }
+};
+
+/*******************************************************************************************************************
+
+                            BATCH RUNNER
+    ------------------------------------------------------------------
+    Runs many independent memory images on all cores. Every worker thread owns one
+    Computer and one FastCpu, built up front on the calling thread, and reloads them
+    (LoadProgram/Load + Reset) for each job, so a job always starts from a freshly
+    reset machine. Jobs are dealt out round-robin into per-worker deques; a worker pops
+    from the back of its own deque and, once that is empty, steals from the front of
+    the others'.
+
+*******************************************************************************************************************/
+
+enum Engine { ENGINE_MICROCODE = 0, ENGINE_FAST, ENGINE_BLOCKS };
+
+struct BatchJob
+{
+    std::vector<WORD> image;
+    uint64_t maxCycles;
+    Engine engine;
+};
+
+struct BatchResult
+{
+    WORD regs[7];                       // SC, PC, MAR, OPR, GPR, Acc, F
+    std::vector<WORD> memory;           // final store of the engine that ran the job
+    uint64_t cycles;
+    uint64_t instructions;              // HLT included
+    bool halted;
+};
+
+class BatchRunner
+{
+private:
+
+    struct Worker
+    {
+        std::unique_ptr<Computer> cpu;
+        std::unique_ptr<FastCpu> fast;
+        std::deque<size_t> queue;
+        std::mutex lock;
+    };
+
+    std::vector<std::unique_ptr<Worker>> mWorkers;
+
+    bool Pop(size_t self, size_t& job)
+    {
+        {
+            Worker& w = *mWorkers[self];
+            std::lock_guard<std::mutex> g(w.lock);
+            if (!w.queue.empty())
+            {
+                job = w.queue.back();
+                w.queue.pop_back();
+                return true;
+            }
+        }
+
+        for (size_t i = 1; i < mWorkers.size(); i++)  // steal
+        {
+            Worker& v = *mWorkers[(self + i) % mWorkers.size()];
+            std::lock_guard<std::mutex> g(v.lock);
+            if (!v.queue.empty())
+            {
+                job = v.queue.front();
+                v.queue.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void Execute(Worker& w, const BatchJob& job, BatchResult& res)
+    {
+        if (job.engine != ENGINE_MICROCODE)
+        {
+            w.fast->SetBlockCache(job.engine == ENGINE_BLOCKS);
+            w.fast->Load(job.image.data(), job.image.size());
+            w.fast->Reset();
+            res.halted = (w.fast->Run(job.maxCycles) == RUN_HALTED);
+            res.cycles = w.fast->Cycles();
+            res.instructions = w.fast->Instructions();
+            w.fast->ReadRegs(res.regs);
+            res.memory.assign(w.fast->State().mem, w.fast->State().mem + 256);
+        }
+        else
+        {
+            w.cpu->LoadProgram(job.image.data(), (WORD)job.image.size());
+            w.cpu->SetSchedule(SCHED_STATIC);
+            w.cpu->Reset();
+            res.halted = (w.cpu->Run(job.maxCycles) == RUN_HALTED);
+            res.cycles = w.cpu->Cycles();
+            res.instructions = w.cpu->Counters().instructions;
+            w.cpu->ReadRegs(res.regs);
+            res.memory.assign(w.cpu->Ram().Data(), w.cpu->Ram().Data() + w.cpu->Ram().Size());
+        }
+    }
+
+    void Work(size_t self, const std::vector<BatchJob>& jobs, std::vector<BatchResult>& results)
+    {
+        size_t job;
+        while (Pop(self, job))
+        {
+            Execute(*mWorkers[self], jobs[job], results[job]);
+        }
+    }
+
+public:
+
+    BatchRunner(unsigned threads = 0, MachineVariant v = VARIANT_CPU5)  // 0 = one worker per hardware thread
+    {
+        if (threads == 0) threads = std::thread::hardware_concurrency();
+        if (threads == 0) threads = 1;
+
+        for (unsigned i = 0; i < threads; i++)
+        {
+            std::unique_ptr<Worker> w(new Worker);
+            w->cpu.reset(new Computer(Geometry(), v));
+            w->fast.reset(new FastCpu);
+            mWorkers.push_back(std::move(w));
+        }
+    }
+
+    size_t Threads()
+    {
+        return mWorkers.size();
+    }
+
+    std::vector<BatchResult> Run(const std::vector<BatchJob>& jobs)
+    {
+        std::vector<BatchResult> results(jobs.size());
+        std::vector<std::thread> threads;
+
+        for (size_t i = 0; i < jobs.size(); i++)
+        {
+            mWorkers[i % mWorkers.size()]->queue.push_back(i);
+        }
+
+        for (size_t t = 1; t < mWorkers.size(); t++)
+        {
+            threads.emplace_back(&BatchRunner::Work, this, t, std::cref(jobs), std::ref(results));
+        }
+        Work(0, jobs, results);
+
+        for (auto& t : threads) t.join();
+        return results;
+    }
+};
+
+/*******************************************************************************************************************
+
+                            MULTIPROCESSOR
+    ------------------------------------------------------------------
+     step           done by
+    ------------------------------------------------------------------
+     epoch          every core runs SMP_QUANTUM (SetQuantum()) clocks on its own thread
+                    group, against its own copy of memory, and logs each clock with
+                    M_GPR or GPR_M: clock, MAR, word written
+     arbitration    the caller sorts the logs by clock; when several cores used the
+                    bus in one clock, core (clock % cores) and the ones after it go
+                    first. Every core but the first owes a wait state.
+     writes         applied to the shared store in that order, so the last core on the
+                    bus wins; every written word is then copied into all cores
+     wait states    a core that owes w sits out its first min(w, quantum) clocks of
+                    the next epoch
+    ------------------------------------------------------------------
+
+    Inside an epoch the cores do not see each other: a core reads its own writes at
+    once and the others' from the next epoch on. With SetQuantum(1) that is the shared
+    bus clock for clock; longer epochs trade that for less synchronization. What
+    happens depends only on the cores' programs, entry points and the quantum, never on
+    the number of threads or their timing, so two runs give the same Digest().
+
+    Each core is a whole Computer (its own Control, registers, Adder), so a Memory bus
+    shared by reference is not needed: the shared store lives here and the cores'
+    Memory objects are its per-core views.
+
+*******************************************************************************************************************/
+
+#define SMP_QUANTUM         1024        // clocks between synchronization points
+#define SMP_CORES_MAX       64
+#define SMP_SPIN            4096        // yields before an idle thread blocks
+
+struct BusAccess                        // one M_GPR/GPR_M clock of a core
+{
+    uint64_t clock;                     // system clock
+    WORD addr;
+    WORD value;                         // word written, GPR_M only
+    BYTE core;
+    BYTE rank;                          // bus priority in this clock, 0 first
+    bool write;
+};
+
+class MultiComputer
+{
+private:
+    struct Core
+    {
+        std::unique_ptr<Computer> cpu;
+        std::vector<BusAccess> log;     // this epoch
+        uint64_t owed;                  // wait states not yet served
+        uint64_t stalls;
+        uint64_t accesses;
+        uint64_t lost;                  // arbitration lost
+    };
+
+    std::vector<Core> mCores;
+    std::vector<WORD> mShared;
+    std::vector<BusAccess> mBus;        // all cores' logs of the epoch, bus order after Arbitrate()
+    std::vector<BYTE> mWritten;         // per address, this epoch
+    std::vector<WORD> mWrittenList;
+    std::vector<std::thread> mThreads;
+    std::atomic<uint64_t> mGeneration;  // bumped to start an epoch, ~0 to stop the threads
+    std::atomic<unsigned> mDone;        // thread groups finished with the epoch
+    std::mutex mLock;                   // for mWake only
+    std::condition_variable mWake;      // a thread that spun SMP_SPIN times without an epoch sleeps here
+    unsigned mGroups;                   // thread groups, core i runs in group i % mGroups
+    uint64_t mQuantum;
+    uint64_t mClock;                    // system clocks since Start()
+    uint64_t mEpochs;
+    uint64_t mConflicts;                // clocks with more than one core on the bus
+    uint64_t mRaces;                    // words written by more than one core in one epoch
+
+    void RunCore(Core& c)               // one epoch of one core
+    {
+        Computer& cpu = *c.cpu;
+        uint64_t wait = std::min(c.owed, mQuantum);
+
+        c.owed -= wait;
+        c.stalls += wait;
+        c.log.clear();
+        for (uint64_t t = wait; t < mQuantum && !cpu.Halted(); t++)
+        {
+            cpu.Step();
+            const CoreState& s = cpu.State();
+            if (s.control & (M_GPR | GPR_M))
+            {
+                WORD mar = s.reg[REG_MAR];
+                bool write = (s.control & GPR_M) != 0;
+                c.log.push_back(BusAccess{ mClock + t, mar, write ? cpu.Ram().Read(mar) : (WORD)0, 0, 0, write });
+            }
+        }
+    }
+
+    void RunGroup(unsigned group)
+    {
+        for (size_t i = group; i < mCores.size(); i += mGroups)
+        {
+            RunCore(mCores[i]);
+        }
+    }
+
+    void Worker(unsigned group)
+    {
+        uint64_t seen = 0;
+        for (;;)
+        {
+            uint64_t g;
+            for (int spin = 0; (g = mGeneration.load(std::memory_order_acquire)) == seen; spin++)
+            {
+                if (spin < SMP_SPIN)
+                {
+                    std::this_thread::yield();
+                    continue;
+                }
+                std::unique_lock<std::mutex> lock(mLock);
+                mWake.wait(lock, [&] { return mGeneration.load(std::memory_order_acquire) != seen; });
+            }
+            if (g == ~0ull)
+            {
+                return;
+            }
+            seen = g;
+            RunGroup(group);
+            mDone.fetch_add(1, std::memory_order_release);
+        }
+    }
+
+    void Arbitrate()                    // at the synchronization point, on the caller's thread
+    {
+        size_t n = mCores.size();
+
+        mBus.clear();
+        for (size_t i = 0; i < n; i++)
+        {
+            for (BusAccess a : mCores[i].log)
+            {
+                a.core = (BYTE)i;
+                a.rank = (BYTE)((i + n - a.clock % n) % n);
+                mBus.push_back(a);
+                mCores[i].accesses++;
+            }
+        }
+        std::sort(mBus.begin(), mBus.end(), [](const BusAccess& a, const BusAccess& b)
+        {
+            return (a.clock != b.clock) ? a.clock < b.clock : a.rank < b.rank;
+        });
+
+        for (size_t i = 0; i < mBus.size(); i++)
+        {
+            const BusAccess& a = mBus[i];
+            if (i > 0 && mBus[i - 1].clock == a.clock)
+            {
+                mCores[a.core].owed++;
+                mCores[a.core].lost++;
+                if (i == 1 || mBus[i - 2].clock != a.clock) mConflicts++;
+            }
+            if (a.write)
+            {
+                BYTE& writer = mWritten[a.addr];    // core + 1, 0xff once a second core wrote it
+                if (writer == 0)
+                {
+                    mWrittenList.push_back(a.addr);
+                    writer = (BYTE)(a.core + 1);
+                }
+                else if (writer != a.core + 1)
+                {
+                    writer = 0xff;
+                }
+                mShared[a.addr] = a.value;
+            }
+        }
+        for (WORD addr : mWrittenList)
+        {
+            mRaces += (mWritten[addr] == 0xff);
+            mWritten[addr] = 0;
+            for (Core& c : mCores) c.cpu->Ram().Write(addr, mShared[addr]);
+        }
+        mWrittenList.clear();
+    }
+
+    void Signal(uint64_t generation)
+    {
+        {
+            std::lock_guard<std::mutex> g(mLock);
+            mGeneration.store(generation, std::memory_order_release);
+        }
+        mWake.notify_all();
+    }
+
+    void StopThreads()
+    {
+        if (!mThreads.empty())
+        {
+            Signal(~0ull);
+            for (auto& t : mThreads) t.join();
+            mThreads.clear();
+        }
+    }
+
+public:
+    MultiComputer(unsigned cores, unsigned threads = 0, const Geometry& g = Geometry(), MachineVariant v = VARIANT_CPU5)  // threads: 0 = one per hardware thread
+    : mGeneration(0), mDone(0), mQuantum(SMP_QUANTUM), mClock(0), mEpochs(0), mConflicts(0), mRaces(0)
+    {
+        if (cores < 1) cores = 1;
+        if (cores > SMP_CORES_MAX) cores = SMP_CORES_MAX;
+        if (threads == 0) threads = std::thread::hardware_concurrency();
+        mGroups = std::max(1u, std::min(threads, cores));
+
+        mCores.resize(cores);
+        for (Core& c : mCores)
+        {
+            c.cpu.reset(new Computer(g, v));
+            c.cpu->SetSchedule(SCHED_EVENT);
+        }
+        mShared.assign(g.words, 0);
+        mWritten.assign(g.words, 0);
+        for (unsigned t = 1; t < mGroups; t++)
+        {
+            mThreads.emplace_back(&MultiComputer::Worker, this, t);
+        }
+    }
+
+    ~MultiComputer()
+    {
+        StopThreads();
+    }
+
+    MultiComputer(const MultiComputer&) = delete;
+    MultiComputer& operator=(const MultiComputer&) = delete;
+
+    void SetQuantum(uint64_t clocks)    // takes effect with the next epoch
+    {
+        mQuantum = clocks ? clocks : 1;
+    }
+
+    bool Load(const WORD* image, size_t n)  // the shared store; false if it does not fit
+    {
+        if (n > mShared.size())
+        {
+            return false;
+        }
+        std::fill(mShared.begin(), mShared.end(), 0);
+        std::copy(image, image + n, mShared.begin());
+        for (Core& c : mCores) c.cpu->LoadProgram(image, (WORD)n);
+        return true;
+    }
+
+    void Start(const std::vector<WORD>& entry)  // core i starts at entry[i], the last one repeats, none = 0
+    {
+        for (size_t i = 0; i < mCores.size(); i++)
+        {
+            Core& c = mCores[i];
+            c.cpu->Start(entry.empty() ? 0 : entry[std::min(i, entry.size() - 1)]);
+            c.owed = c.stalls = c.accesses = c.lost = 0;
+            c.log.clear();
+        }
+        mClock = mEpochs = mConflicts = mRaces = 0;
+    }
+
+    bool Halted()                       // every core
+    {
+        for (Core& c : mCores)
+        {
+            if (!c.cpu->Halted()) return false;
+        }
+        return true;
+    }
+
+    RunStatus Run(uint64_t maxClocks)   // whole epochs until every core halted or maxClocks system clocks
+    {
+        uint64_t end = (maxClocks > UINT64_MAX - mClock) ? UINT64_MAX : mClock + maxClocks;
+        while (!Halted() && mClock < end)
+        {
+            mDone.store(0, std::memory_order_relaxed);
+            Signal(mGeneration.load(std::memory_order_relaxed) + 1);
+            RunGroup(0);
+            while (mDone.load(std::memory_order_acquire) != mGroups - 1)
+            {
+                std::this_thread::yield();
+            }
+            Arbitrate();
+            mClock += mQuantum;
+            mEpochs++;
+        }
+        return Halted() ? RUN_HALTED : RUN_PAUSED;
+    }
+
+    size_t Cores()
+    {
+        return mCores.size();
+    }
+
+    unsigned Threads()
+    {
+        return mGroups;
+    }
+
+    Computer& Cpu(size_t i)
+    {
+        return *mCores[i].cpu;
+    }
+
+    const std::vector<WORD>& Shared()
+    {
+        return mShared;
+    }
+
+    uint64_t Clock()
+    {
+        return mClock;
+    }
+
+    uint64_t Stalls(size_t i)
+    {
+        return mCores[i].stalls;
+    }
+
+    uint64_t Digest()                   // FNV-1a of the shared store and every core's registers and clocks
+    {
+        uint64_t h = 14695981039346656037ull;
+        auto mix = [&h](uint64_t v) { h = (h ^ v) * 1099511628211ull; };
+        for (WORD w : mShared) mix(w);
+        for (Core& c : mCores)
+        {
+            for (WORD r : c.cpu->State().reg) mix(r);
+            mix(c.cpu->Cycles());
+        }
+        return h;
+    }
+
+    void Display(std::ostream& os)
+    {
+        os << "\n****** MULTIPROCESSOR ****** " << mCores.size() << " cores on " << mGroups << " threads, quantum "
+           << mQuantum << ", " << mClock << " clocks in " << mEpochs << " epochs\n";
+        os << "core\tclocks\tstalls\tbus\tlost\tPC\tAcc\thalted\n";
+        for (size_t i = 0; i < mCores.size(); i++)
+        {
+            Core& c = mCores[i];
+            os << i << "\t" << c.cpu->Cycles() << "\t" << c.stalls << "\t" << c.accesses << "\t" << c.lost << "\t"
+               << c.cpu->State().reg[REG_PC] << "\t" << c.cpu->State().reg[REG_ACC] << "\t" << c.cpu->Halted() << "\n";
+        }
+        os << "bus conflicts: " << mConflicts << " clocks\n";
+        os << "write races  : " << mRaces << " words\n";
+        os << "digest       : " << std::hex << Digest() << std::dec << "\n";
+    }
+};
+
+/*******************************************************************************************************************
+
+                            PROGRAM FUZZER
+    ------------------------------------------------------------------
+     address        content
+    ------------------------------------------------------------------
+     0              JMP main
+     1 ..           subroutines: return slot, body, JMPI slot (as DBL)
+     main ..        body, HLT
+     .. 0xDF        loop constants and counters, growing down
+     0xE0 - 0xFF    FUZZ_DATA_WORDS random data words, the only STA targets
+    ------------------------------------------------------------------
+     body item      code
+    ------------------------------------------------------------------
+     straight       CRA/CTA/ITA/CRF/CTF/ROR/ROL, ADD/ADDI/STA on data
+                    or constants, SFZ followed by one of these
+     loop           CRA, ADD -n, STA c, top: body, ISZ c, JMP top
+     call           CSR on a subroutine built before this one
+    ------------------------------------------------------------------
+
+    ProgramFuzzer::Generate(seed, image) builds a random 256-word image that is sure to
+    halt. Code never writes into code, counters or constants, so there is no self-
+    modification; every loop loads its own counter before it starts, and the call graph
+    has no cycles. Each item is built against a budget of executed instructions and
+    reports what it used, so a loop picks its count from what its body left over. The
+    whole program stays below FUZZ_MAX_INSTRUCTIONS; 0..1 of that is drawn per seed,
+    which gives short and long jobs in one batch.
+
+    The same seed gives the same image on every platform (SplitMix), so --fuzz and
+    --cosim print seeds to reproduce a failure or a slow job.
+
+*******************************************************************************************************************/
+
+#define FUZZ_DATA           0xe0        // first data word
+#define FUZZ_DATA_WORDS     32
+#define FUZZ_MAX_INSTRUCTIONS 50000     // executed, HLT included
+#define FUZZ_SUB_BUDGET     2000        // executed per call of a subroutine
+#define FUZZ_SUBS           4           // at most
+#define FUZZ_LOOP_MAX       16          // iterations
+#define FUZZ_DEPTH          2           // loops inside loops
+#define FUZZ_BODY           8           // items per body, at most
+
+struct SplitMix                         // small, seedable, the same sequence on every platform
+{
+    uint64_t mState;
+
+    SplitMix(uint64_t seed) : mState(seed) {}
+
+    uint64_t Next()
+    {
+        uint64_t z = (mState += 0x9e3779b97f4a7c15ull);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        return z ^ (z >> 31);
+    }
+};
+
+class ProgramFuzzer
+{
+private:
+    SplitMix mRng;
+    std::vector<WORD>* mImage;
+    WORD mCode;                         // next code word
+    WORD mConst;                        // lowest constant or counter so far
+    WORD mOpen;                         // words still owed to the constructs that are open
+    std::vector<WORD> mSubs;            // return slots of the subroutines built so far
+    std::vector<uint64_t> mSubCost;     // executed instructions per call, CSR included
+
+    WORD Pick(uint64_t n)               // 0..n-1
+    {
+        return (WORD)(mRng.Next() % n);
+    }
+
+    bool Room(WORD code, WORD constants)
+    {
+        return mCode + code + mOpen + constants <= mConst;
+    }
+
+    void Emit(BYTE opcode, WORD ad = 0)
+    {
+        (*mImage)[mCode++] = (WORD)((opcode << 8) | (ad & 0x00ff));
+    }
+
+    WORD Constant(WORD value)
+    {
+        (*mImage)[--mConst] = value;
+        return mConst;
+    }
+
+    uint64_t Straight(uint64_t budget)  // one item without control flow
+    {
+        static const BYTE alu[] = { OPC_CRA, OPC_CTA, OPC_ITA, OPC_CRF, OPC_CTF, OPC_ROR, OPC_ROL };
+        WORD data = (WORD)(FUZZ_DATA + Pick(FUZZ_DATA_WORDS));
+        bool skip = budget >= 2 && Room(2, 0) && Pick(8) == 0;
+
+        if (skip)
+        {
+            Emit(OPC_SFZ);
+        }
+        switch (Pick(6))
+        {
+        case 0:  Emit(OPC_ADD, (Pick(2) || mConst == FUZZ_DATA) ? data : (WORD)(mConst + Pick(FUZZ_DATA - mConst))); break;
+        case 1:  Emit(OPC_ADDI, data); break;
+        case 2:  Emit(OPC_STA, data); break;
+        default: Emit(alu[Pick(sizeof(alu))]); break;
+        }
+        return skip ? 2 : 1;
+    }
+
+    uint64_t Loop(int depth, uint64_t budget)   // CRA, ADD k, STA c, body, ISZ c, JMP top
+    {
+        WORD k = Constant(0);
+        WORD c = Constant(0);
+        uint64_t body;
+        WORD n;
+
+        Emit(OPC_CRA);
+        Emit(OPC_ADD, k);
+        Emit(OPC_STA, c);
+        WORD top = mCode;
+        mOpen += 2;
+        body = Body(depth + 1, (budget - 5) / (1 + Pick(FUZZ_LOOP_MAX)));
+        mOpen -= 2;
+        Emit(OPC_ISZ, c);
+        Emit(OPC_JMP, top);
+
+        n = (WORD)std::min<uint64_t>(FUZZ_LOOP_MAX, (budget - 3) / (body + 2));  // body, ISZ, JMP per pass; the last JMP is skipped
+        n = (WORD)(1 + Pick(n));
+        (*mImage)[k] = (WORD)((0x1000 - n) & 0x0fff);   // -n: ISZ reaches 0 after n passes
+        return 3 + n * (body + 2) - 1;
+    }
+
+    uint64_t Call(uint64_t budget)      // CSR on a subroutine that fits, else a straight item
+    {
+        WORD start = Pick(mSubs.size() + 1);
+        for (size_t i = 0; i < mSubs.size(); i++)
+        {
+            size_t s = (start + i) % mSubs.size();
+            if (mSubCost[s] <= budget)
+            {
+                Emit(OPC_CSR, mSubs[s]);
+                return mSubCost[s];
+            }
+        }
+        return Straight(budget);
+    }
+
+    uint64_t Body(int depth, uint64_t budget)   // at least one item; returns the instructions it executes at most
+    {
+        uint64_t used = 0;
+        int items = 1 + Pick(FUZZ_BODY);
+
+        for (int i = 0; i < items && used < budget; i++)
+        {
+            uint64_t left = budget - used;
+            WORD kind = Pick(8);
+
+            if (kind >= 6 && depth < FUZZ_DEPTH && left >= 8 && Room(7, 2))
+            {
+                used += Loop(depth, left);
+            }
+            else if (kind == 5 && !mSubs.empty() && Room(1, 0))
+            {
+                used += Call(left);
+            }
+            else if (Room(1, 0))
+            {
+                used += Straight(left);
+            }
+        }
+        if (used == 0)              // no room left: a body of one plain instruction
+        {
+            Emit(OPC_CRF);
+            used = 1;
+        }
+        return used;
+    }
+
+public:
+    ProgramFuzzer() : mRng(0), mImage(nullptr), mCode(0), mConst(FUZZ_DATA), mOpen(0)
+    {
+    }
+
+    uint64_t Generate(uint64_t seed, std::vector<WORD>& image)  // returns the most instructions it can execute
+    {
+        mRng = SplitMix(seed);
+        mImage = &image;
+        image.assign(256, 0);
+        mCode = 0;
+        mConst = FUZZ_DATA;
+        mSubs.clear();
+        mSubCost.clear();
+        for (WORD a = FUZZ_DATA; a < FUZZ_DATA + FUZZ_DATA_WORDS; a++)
+        {
+            image[a] = (WORD)(mRng.Next() & 0x0fff);
+        }
+
+        Emit(OPC_JMP);                  // to main, patched below
+        for (int s = Pick(FUZZ_SUBS + 1); s > 0 && Room(8, 4); s--)
+        {
+            WORD slot = mCode++;        // CSR stores the return address here and continues at slot + 1
+            mOpen = 3;                  // JMPI, and a one-word main body with its HLT
+            uint64_t cost = Body(0, FUZZ_SUB_BUDGET - 2);
+            Emit(OPC_JMPI, slot);
+            mSubs.push_back(slot);
+            mSubCost.push_back(cost + 2);   // CSR, body, JMPI
+        }
+
+        image[0] |= mCode;
+        mOpen = 1;
+        uint64_t budget = 1 + Pick(FUZZ_MAX_INSTRUCTIONS - 2);
+        uint64_t cost = Body(0, budget);
+        mOpen = 0;
+        Emit(OPC_HLT);
+        return cost + 2;                // JMP main and HLT
+    }
+};
+
+/*******************************************************************************************************************
+
+                            CO-SIMULATION
+    ------------------------------------------------------------------
+     engine         stepped with                        compared after
+    ------------------------------------------------------------------
+     COSIM_FAST     FastCpu::Run(1)                     every instruction
+     COSIM_BLOCKS   FastCpu::Run(COSIM_BLOCK_CLOCKS),   every run of blocks, at most
+                    block cache on                      COSIM_BLOCK_CLOCKS + 7 clocks
+     COSIM_LANES    LaneCpu::Run(1), one data word      every instruction, every lane:
+                    varied per lane                     lane 0 against the reference,
+                                                        lane l against a FastCpu
+    ------------------------------------------------------------------
+
+    CoSim runs the microcoded Computer (SCHED_STATIC) as the reference next to one of the
+    instruction engines on the same image. The engines stop at instruction boundaries,
+    right after fetch step 0 of the next instruction (SC = 1, MAR = PC); the reference is
+    clocked to the same cycle, then the registers, the halt state and all 256 words of
+    memory have to be equal. The first difference ends the run with a CoSimReport: the
+    instruction that led to it and the first field that differs, with both values.
+
+    The lanes do not all run the image as given: lane l gets M[a] + l at the operand
+    address a of the first ADD, ADDI or ISZ in it, the way --sweep varies its word, so
+    they split at the first SFZ, ISZ or JMPI that depends on it and take the masked and
+    blended paths. Lane 0 keeps the image and is checked against the reference; every
+    other lane is checked against a FastCpu of its own running the same varied image
+    (FastCpu itself is what COSIM_FAST checks). The run ends when lane 0 halts or at
+    maxCycles, like it does for the other engines.
+
+    --cosim runs [seed] [fuzz] checks the loaded image, then 'runs' random 256-word
+    images on every engine, or ProgramFuzzer programs with 'fuzz'. Image i comes from
+    seed + i and a divergence prints that seed, so --cosim 1 <seed> runs the failing
+    image again.
+
+*******************************************************************************************************************/
+
+#define COSIM_BLOCK_CLOCKS  64
+#define COSIM_MAX_CYCLES    20000       // per random image, most of them never halt
+
+enum CoSimEngine { COSIM_FAST = 0, COSIM_BLOCKS, COSIM_LANES, COSIM_ENGINES };
+
+enum CoSimField                         // CoSimReport::field; 0..REG_COUNT-1 are RegIndex
+{
+    COSIM_CYCLES = REG_COUNT,
+    COSIM_HALT,
+    COSIM_MEMORY
+};
+
+struct CoSimReport
+{
+    bool diverged;
+    uint64_t compared;                  // instruction boundaries that matched
+    uint64_t cycle;                     // reference clocks at the divergence
+    WORD pc, word;                      // the instruction the engine ran last from there
+    int field;                          // RegIndex or CoSimField
+    int lane;                           // COSIM_LANES only, else 0
+    WORD addr;                          // COSIM_MEMORY
+    uint64_t reference, engine;
+
+    void Display(std::ostream& os, const char* engineName)
+    {
+        static const char* const fields[] = { "cycles", "halted", "memory" };
+
+        if (!diverged)
+        {
+            os << engineName << ": " << compared << " boundaries match\n";
+            return;
+        }
+        os << engineName << ": diverged after " << compared << " boundaries, clock " << cycle
+           << ", PC " << pc << " (word " << word << ")";
+        if (lane) os << ", lane " << lane;
+        os << "\n  " << ((field < REG_COUNT) ? RegNames[field] : fields[field - REG_COUNT]);
+        if (field == COSIM_MEMORY) os << " M[" << addr << "]";
+        os << ": reference " << reference << ", engine " << this->engine << "\n";
+    }
+};
+
+class CoSim
+{
+private:
+    Computer& mRef;
+    FastCpu mFast;
+    LaneCpu mLanes;
+    FastCpu mSide[LANES];               // COSIM_LANES: lane l > 0 on its own image; mSide[0] is not used
+    WORD mPc[LANES], mWord[LANES];      // the instruction every lane runs next
+    WORD mMem[256];
+
+    bool Differs(int field, uint64_t reference, uint64_t engine, CoSimReport& rep)
+    {
+        if (reference == engine)
+        {
+            return false;
+        }
+        rep.diverged = true;
+        rep.field = field;
+        rep.reference = reference;
+        rep.engine = engine;
+        return true;
+    }
+
+    bool Compare(const WORD* regs, uint64_t cycles, bool halted, const WORD* mem, CoSimReport& rep)    // true if equal; mem may be nullptr
+    {
+        WORD ref[REG_COUNT];
+
+        mRef.ReadRegs(ref);
+        rep.cycle = mRef.Cycles();
+        for (int r = 0; r < REG_COUNT; r++)
+        {
+            if (Differs(r, ref[r], regs[r], rep)) return false;
+        }
+        if (Differs(COSIM_CYCLES, mRef.Cycles(), cycles, rep) || Differs(COSIM_HALT, mRef.Halted(), halted, rep))
+        {
+            return false;
+        }
+        if (mem && memcmp(mRef.Ram().Data(), mem, 256 * sizeof(WORD)) != 0)
+        {
+            for (WORD a = 0; a < 256; a++)
+            {
+                if (Differs(COSIM_MEMORY, mRef.Ram().Read(a), mem[a], rep))
+                {
+                    rep.addr = a;
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    bool CompareLane(int lane, CoSimReport& rep)    // lane > 0 against mSide[lane]; true if equal
+    {
+        FastCpu& side = mSide[lane];
+        WORD regs[REG_COUNT], ref[REG_COUNT];
+
+        mLanes.ReadRegs(lane, regs);
+        side.ReadRegs(ref);
+        rep.cycle = side.Cycles();
+        for (int r = 0; r < REG_COUNT; r++)
+        {
+            if (Differs(r, ref[r], regs[r], rep)) return false;
+        }
+        if (Differs(COSIM_CYCLES, side.Cycles(), mLanes.Cycles(lane), rep) || Differs(COSIM_HALT, side.Halted(), mLanes.Halted(lane), rep))
+        {
+            return false;
+        }
+        mLanes.ReadMem(lane, mMem);
+        for (WORD a = 0; a < 256; a++)
+        {
+            if (Differs(COSIM_MEMORY, side.State().mem[a], mMem[a], rep))
+            {
+                rep.addr = a;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static WORD VariedWord(const WORD* image, size_t n)     // operand address of the first ADD, ADDI or ISZ, else 0
+    {
+        for (size_t i = 0; i < n && i < 256; i++)
+        {
+            WORD opcode = (image[i] >> 8) & 0x000f;
+            if (opcode == OPC_ADD || opcode == OPC_ADDI || opcode == OPC_ISZ)
+            {
+                return image[i] & 0x00ff;
+            }
+        }
+        return 0;
+    }
+
+    void LoadLanes(const WORD* image, size_t n)
+    {
+        WORD a = VariedWord(image, n);
+        WORD w = (a < n) ? image[a] : 0;
+
+        mLanes.Load(image, n);
+        mLanes.Reset();
+        for (int l = 1; l < LANES; l++)
+        {
+            WORD value = (WORD)((w + l) & 0x0fff);
+            mLanes.SetWord(l, a, value);
+            mSide[l].SetBlockCache(false);
+            mSide[l].Load(image, n);
+            mSide[l].State().mem[a] = value;
+            mSide[l].FlushBlocks();
+            mSide[l].Reset();
+        }
+    }
+
+public:
+    CoSim(Computer& ref) : mRef(ref)
+    {
+    }
+
+    bool Run(const WORD* image, size_t n, CoSimEngine engine, uint64_t maxCycles, CoSimReport& rep)    // true = no divergence
+    {
+        WORD regs[REG_COUNT];
+
+        memset(&rep, 0, sizeof(rep));
+        mRef.Breaks().Clear();          // a RUN_BREAK would look like a short instruction
+        mRef.SetSchedule(SCHED_STATIC);
+        mRef.LoadProgram(image, (WORD)std::min<size_t>(n, 256));
+        mRef.Reset();
+        mRef.Run(1);                    // fetch step 0, where the engines start
+        if (engine == COSIM_LANES)
+        {
+            LoadLanes(image, n);
+        }
+        else
+        {
+            mFast.SetBlockCache(engine == COSIM_BLOCKS);
+            mFast.Load(image, n);
+            mFast.Reset();
+        }
+
+        for (;;)
+        {
+            uint64_t target;
+            bool halted;
+
+            if (engine == COSIM_LANES)
+            {
+                mLanes.ReadRegs(0, regs);
+                mLanes.ReadMem(0, mMem);
+                if (!Compare(regs, mLanes.Cycles(0), mLanes.Halted(0), mMem, rep)) return false;
+                for (int l = 1; l < LANES; l++)
+                {
+                    if (!CompareLane(l, rep))
+                    {
+                        rep.lane = l;
+                        rep.pc = mPc[l];
+                        rep.word = mWord[l];
+                        return false;
+                    }
+                }
+                rep.lane = 0;
+                halted = mLanes.Halted(0);
+            }
+            else
+            {
+                mFast.ReadRegs(regs);
+                if (!Compare(regs, mFast.Cycles(), mFast.Halted(), mFast.State().mem, rep)) return false;
+                halted = mFast.Halted();
+            }
+            if (halted || mRef.Cycles() >= maxCycles)
+            {
+                return true;
+            }
+
+            rep.compared++;
+            rep.pc = mRef.State().reg[REG_MAR];     // MAR = PC at the boundary
+            rep.word = mRef.Ram().Read(rep.pc);
+            if (engine == COSIM_LANES)
+            {
+                for (int l = 1; l < LANES; l++)
+                {
+                    mPc[l] = mSide[l].State().mar;
+                    mWord[l] = mSide[l].State().mem[mPc[l]];
+                    mSide[l].Run(1);
+                }
+                mLanes.Run(1);
+                target = mLanes.Cycles(0);
+            }
+            else
+            {
+                mFast.Run((engine == COSIM_BLOCKS) ? COSIM_BLOCK_CLOCKS : 1);
+                target = mFast.Cycles();
+            }
+            if (target > mRef.Cycles())
+            {
+                mRef.Run(target - mRef.Cycles());
+            }
+        }
+    }
+};
+
+#endif // TAUB_H